@@ -0,0 +1,42 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
+#include "../include/Animations.h"
+#include "../include/BinarySymbols.h"
+
+#if NUM_OF_DISPLAY_DIGITS == 4
+
+// symbols are calculated for the wiring set in BinarySymbols.h.
+#define BLANK segmentSymbol(0)
+#define ALL segmentSymbol(0xFF) // all segments and dot.
+#define SPIN(segment) {{segmentSymbol(segment), segmentSymbol(segment), segmentSymbol(segment), segmentSymbol(segment)}, 100}
+#define HYPHEN segmentSymbol(SEGMENT_G)
+
+const AnimationFrame animationSpinner[NUM_OF_SPINNER_FRAMES] PROGMEM = {
+  SPIN(SEGMENT_A),
+  SPIN(SEGMENT_B),
+  SPIN(SEGMENT_C),
+  SPIN(SEGMENT_D),
+  SPIN(SEGMENT_E),
+  SPIN(SEGMENT_F)
+};
+
+const AnimationFrame animationBoot[NUM_OF_BOOT_FRAMES] PROGMEM = {
+  {{ALL, BLANK, BLANK, BLANK}, 150},
+  {{ALL, ALL, BLANK, BLANK}, 150},
+  {{ALL, ALL, ALL, BLANK}, 150},
+  {{ALL, ALL, ALL, ALL}, 500},
+  {{BLANK, BLANK, BLANK, BLANK}, 200}
+};
+
+const AnimationFrame animationWipe[NUM_OF_WIPE_FRAMES] PROGMEM = {
+  {{HYPHEN, BLANK, BLANK, BLANK}, 60},
+  {{BLANK, HYPHEN, BLANK, BLANK}, 60},
+  {{BLANK, BLANK, HYPHEN, BLANK}, 60},
+  {{BLANK, BLANK, BLANK, HYPHEN}, 60},
+  {{BLANK, BLANK, BLANK, BLANK}, 60}
+};
+
+#endif
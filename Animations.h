@@ -0,0 +1,45 @@
+/*
+  Animations.h - Ready to use animations for the Seg4DigitHC164 library.
+  The frame tables are stored in flash memory (PROGMEM) and can be played
+  with Seg4DigitHC164::playAnimation().
+
+  Example:
+  display.playAnimation(animationSpinner, NUM_OF_SPINNER_FRAMES, 'l');
+
+  Included animations:
+  - animationSpinner: one segment running around every digit.
+    Meant to be played in loop mode while waiting.
+  - animationBoot: digits light up one by one (all segments and
+    dots), useful as a segment test at startup. Play as one-shot.
+  - animationWipe: a hyphen sweeps from left to right. Play as
+    one-shot right before a show*() call, the new value appears
+    when the animation ends.
+
+  The symbols in these tables are written for a 4 digit display.
+
+  For study purposes.
+*/
+
+#ifndef ANIMATIONS_H
+#define ANIMATIONS_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
+#include "../include/Seg4DigitHC164.h"
+
+#if NUM_OF_DISPLAY_DIGITS == 4
+
+#define NUM_OF_SPINNER_FRAMES 6
+#define NUM_OF_BOOT_FRAMES 5
+#define NUM_OF_WIPE_FRAMES 5
+
+extern const AnimationFrame animationSpinner[NUM_OF_SPINNER_FRAMES] PROGMEM;
+extern const AnimationFrame animationBoot[NUM_OF_BOOT_FRAMES] PROGMEM;
+extern const AnimationFrame animationWipe[NUM_OF_WIPE_FRAMES] PROGMEM;
+
+#endif
+
+#endif
@@ -1,6 +1,34 @@
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
 #include "../include/BinarySymbols.h"
 
+// definitions of the symbols (values are calculated in the header).
+constexpr byte BinarySymbols::blank;
+constexpr byte BinarySymbols::zero;
+constexpr byte BinarySymbols::one;
+constexpr byte BinarySymbols::two;
+constexpr byte BinarySymbols::three;
+constexpr byte BinarySymbols::four;
+constexpr byte BinarySymbols::five;
+constexpr byte BinarySymbols::six;
+constexpr byte BinarySymbols::seven;
+constexpr byte BinarySymbols::eight;
+constexpr byte BinarySymbols::nine;
+constexpr byte BinarySymbols::hyphen;
+constexpr byte BinarySymbols::letter_A;
+constexpr byte BinarySymbols::letter_b;
+constexpr byte BinarySymbols::letter_C;
+constexpr byte BinarySymbols::letter_d;
+constexpr byte BinarySymbols::letter_E;
+constexpr byte BinarySymbols::letter_F;
+constexpr byte BinarySymbols::letter_r;
+constexpr byte BinarySymbols::dotMask;
+constexpr byte BinarySymbols::levelHorizontal[3];
+constexpr byte BinarySymbols::levelVertical[4];
+
 BinarySymbols::BinarySymbols()
 {
   // no intialisation actions necessary.
@@ -105,7 +133,9 @@ byte BinarySymbols::convertCharToSymbol(char input) {
       return hyphen;
       break;
     default:
+#if SEG4DIGIT_DEBUG
       Serial.print("error in BinarySymbols::convertCharToDisplayDigit(): invalid input char: ");Serial.println(input);
+#endif
       return zero;
       break;
   }
@@ -114,6 +144,11 @@ byte BinarySymbols::convertCharToSymbol(char input) {
 
 byte BinarySymbols::addDot(byte input)
 {
+#if SEGMENT_COMMON_ANODE
   // set bit that controls dot to 0 to activate led (0 = on).
-  return input & 0b11111110;
+  return input & ~dotMask;
+#else
+  // set bit that controls dot to 1 to activate led (1 = on).
+  return input | dotMask;
+#endif
 }
\ No newline at end of file
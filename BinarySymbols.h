@@ -16,6 +16,28 @@
   Example: 
   byte 00101001 results in '3'.
 
+  Other wiring:
+  The mapping above is the default. Boards
+  that are wired differently, or use a
+  common cathode display, can change the
+  SEGMENT_BIT_* defines (bit number 0-7,
+  0 = least significant bit) and the
+  SEGMENT_COMMON_ANODE define below.
+  Every define can be changed on its own,
+  the compiler checks that the bit numbers
+  are 0-7 and all different.
+  All symbols are calculated from these
+  defines by the compiler (constexpr), so
+  there is no conversion at runtime.
+
+  Segment names used in the code:
+       ____
+      |  a |
+    f |____| b
+      |  g |
+    e |____| c  [] dp
+        d
+
   Included characters:
   01234567890
   AbCdEFr-
@@ -33,6 +55,15 @@
   letters for showing Celcius or
   Fahrenheit and 'Err' as an
   error symbol.
+
+  Level tables:
+  Segment fill patterns used for showing
+  a bar graph, indexed by fill level.
+  Horizontal (per digit):
+  0 = empty, 1 = left half, 2 = full.
+  Vertical (same for every digit):
+  0 = empty, 1 = bottom, 2 = bottom and
+  middle, 3 = bottom, middle and top.
   
   Created 04-06-2021 by Tim Ruterink.
   For study purposes.
@@ -41,7 +72,93 @@
 #ifndef BINARYSYMBOLS_H
 #define BINARYSYMBOLS_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
+
+// bit number of each segment in a symbol byte (default wiring), each one
+// can be overridden.
+#ifndef SEGMENT_BIT_A
+#define SEGMENT_BIT_A 6
+#endif
+#ifndef SEGMENT_BIT_B
+#define SEGMENT_BIT_B 1
+#endif
+#ifndef SEGMENT_BIT_C
+#define SEGMENT_BIT_C 2
+#endif
+#ifndef SEGMENT_BIT_D
+#define SEGMENT_BIT_D 4
+#endif
+#ifndef SEGMENT_BIT_E
+#define SEGMENT_BIT_E 3
+#endif
+#ifndef SEGMENT_BIT_F
+#define SEGMENT_BIT_F 5
+#endif
+#ifndef SEGMENT_BIT_G
+#define SEGMENT_BIT_G 7
+#endif
+#ifndef SEGMENT_BIT_DP
+#define SEGMENT_BIT_DP 0
+#endif
+
+static_assert(SEGMENT_BIT_A >= 0 && SEGMENT_BIT_A <= 7 &&
+  SEGMENT_BIT_B >= 0 && SEGMENT_BIT_B <= 7 &&
+  SEGMENT_BIT_C >= 0 && SEGMENT_BIT_C <= 7 &&
+  SEGMENT_BIT_D >= 0 && SEGMENT_BIT_D <= 7 &&
+  SEGMENT_BIT_E >= 0 && SEGMENT_BIT_E <= 7 &&
+  SEGMENT_BIT_F >= 0 && SEGMENT_BIT_F <= 7 &&
+  SEGMENT_BIT_G >= 0 && SEGMENT_BIT_G <= 7 &&
+  SEGMENT_BIT_DP >= 0 && SEGMENT_BIT_DP <= 7,
+  "SEGMENT_BIT_* must be a bit number from 0 to 7.");
+
+// eight bit numbers from 0 to 7 use every bit exactly once when they are all different.
+static_assert(((1 << SEGMENT_BIT_A) | (1 << SEGMENT_BIT_B) | (1 << SEGMENT_BIT_C) |
+  (1 << SEGMENT_BIT_D) | (1 << SEGMENT_BIT_E) | (1 << SEGMENT_BIT_F) |
+  (1 << SEGMENT_BIT_G) | (1 << SEGMENT_BIT_DP)) == 0xFF,
+  "SEGMENT_BIT_* values must all be different.");
+
+// 1 = print debug messages to Serial (see Seg4DigitHC164.h).
+#ifndef SEG4DIGIT_DEBUG
+#define SEG4DIGIT_DEBUG 0
+#endif
+
+// 1 = common anode (0 = led on), 0 = common cathode (1 = led on).
+#ifndef SEGMENT_COMMON_ANODE
+#define SEGMENT_COMMON_ANODE 1
+#endif
+
+// wiring independent segment flags, combine with | and convert with segmentSymbol().
+#define SEGMENT_A 0x01
+#define SEGMENT_B 0x02
+#define SEGMENT_C 0x04
+#define SEGMENT_D 0x08
+#define SEGMENT_E 0x10
+#define SEGMENT_F 0x20
+#define SEGMENT_G 0x40
+#define SEGMENT_DP 0x80
+
+constexpr byte wireSegments(byte segments)
+// move every segment flag to the bit it is wired to.
+{
+  return ((segments & SEGMENT_A) ? (1 << SEGMENT_BIT_A) : 0) |
+    ((segments & SEGMENT_B) ? (1 << SEGMENT_BIT_B) : 0) |
+    ((segments & SEGMENT_C) ? (1 << SEGMENT_BIT_C) : 0) |
+    ((segments & SEGMENT_D) ? (1 << SEGMENT_BIT_D) : 0) |
+    ((segments & SEGMENT_E) ? (1 << SEGMENT_BIT_E) : 0) |
+    ((segments & SEGMENT_F) ? (1 << SEGMENT_BIT_F) : 0) |
+    ((segments & SEGMENT_G) ? (1 << SEGMENT_BIT_G) : 0) |
+    ((segments & SEGMENT_DP) ? (1 << SEGMENT_BIT_DP) : 0);
+}
+
+constexpr byte segmentSymbol(byte segments)
+// symbol byte with the given segments lit, using the wiring and polarity defines.
+{
+  return SEGMENT_COMMON_ANODE ? (byte)~wireSegments(segments) : wireSegments(segments);
+}
 
 class BinarySymbols {
   private:
@@ -49,27 +166,42 @@ class BinarySymbols {
   public:
     BinarySymbols();
 
-    const byte blank = 0b11111111;
-    const byte zero = 0b10000001;
-    const byte one = 0b11111001;
-    const byte two = 0b00100101;
-    const byte three = 0b00101001;
-    const byte four = 0b01011001;
-    const byte five = 0b00001011;
-    const byte six = 0b00000011;
-    const byte seven = 0b10111001;
-    const byte eight = 0b00000001;
-    const byte nine = 0b00001001;
-
-    const byte hyphen = 0b01111111;
-
-    const byte letter_A = 0b00010001;
-    const byte letter_b = 0b01000011;
-    const byte letter_C = 0b10000111;
-    const byte letter_d = 0b01100001;
-    const byte letter_E = 0b00000111;
-    const byte letter_F = 0b00010111;
-    const byte letter_r = 0b01110111;
+    static constexpr byte blank = segmentSymbol(0);
+    static constexpr byte zero = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_D | SEGMENT_E | SEGMENT_F);
+    static constexpr byte one = segmentSymbol(SEGMENT_B | SEGMENT_C);
+    static constexpr byte two = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_D | SEGMENT_E | SEGMENT_G);
+    static constexpr byte three = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_D | SEGMENT_G);
+    static constexpr byte four = segmentSymbol(SEGMENT_B | SEGMENT_C | SEGMENT_F | SEGMENT_G);
+    static constexpr byte five = segmentSymbol(SEGMENT_A | SEGMENT_C | SEGMENT_D | SEGMENT_F | SEGMENT_G);
+    static constexpr byte six = segmentSymbol(SEGMENT_A | SEGMENT_C | SEGMENT_D | SEGMENT_E | SEGMENT_F | SEGMENT_G);
+    static constexpr byte seven = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_C);
+    static constexpr byte eight = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_D | SEGMENT_E | SEGMENT_F | SEGMENT_G);
+    static constexpr byte nine = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_D | SEGMENT_F | SEGMENT_G);
+
+    static constexpr byte hyphen = segmentSymbol(SEGMENT_G);
+
+    static constexpr byte letter_A = segmentSymbol(SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_E | SEGMENT_F | SEGMENT_G);
+    static constexpr byte letter_b = segmentSymbol(SEGMENT_C | SEGMENT_D | SEGMENT_E | SEGMENT_F | SEGMENT_G);
+    static constexpr byte letter_C = segmentSymbol(SEGMENT_A | SEGMENT_D | SEGMENT_E | SEGMENT_F);
+    static constexpr byte letter_d = segmentSymbol(SEGMENT_B | SEGMENT_C | SEGMENT_D | SEGMENT_E | SEGMENT_G);
+    static constexpr byte letter_E = segmentSymbol(SEGMENT_A | SEGMENT_D | SEGMENT_E | SEGMENT_F | SEGMENT_G);
+    static constexpr byte letter_F = segmentSymbol(SEGMENT_A | SEGMENT_E | SEGMENT_F | SEGMENT_G);
+    static constexpr byte letter_r = segmentSymbol(SEGMENT_E | SEGMENT_G);
+
+    // dot bit, the only bit addDot() changes.
+    static constexpr byte dotMask = wireSegments(SEGMENT_DP);
+
+    static constexpr byte levelHorizontal[3] = {
+      segmentSymbol(0),
+      segmentSymbol(SEGMENT_E | SEGMENT_F),
+      segmentSymbol(SEGMENT_B | SEGMENT_C | SEGMENT_E | SEGMENT_F)
+    };
+    static constexpr byte levelVertical[4] = {
+      segmentSymbol(0),
+      segmentSymbol(SEGMENT_D),
+      segmentSymbol(SEGMENT_D | SEGMENT_G),
+      segmentSymbol(SEGMENT_A | SEGMENT_D | SEGMENT_G)
+    };
 
     byte convertCharToSymbol(char input);
 
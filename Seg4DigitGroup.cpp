@@ -0,0 +1,113 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
+#include "../include/Seg4DigitGroup.h"
+
+/*
+  -----------------
+  CONSTRUCTOR
+  -----------------
+*/
+
+Seg4DigitGroup::Seg4DigitGroup()
+{
+  numOfDisplays = 0;
+  nextDisplay = 0;
+  slotMicros = 1000;
+  timeStampSlot = 0;
+  cpuTimeMicros = 0;
+  numOfTicks = 0;
+}
+
+
+
+/*
+  -----------------
+  PUBLIC METHODS
+  -----------------
+*/
+
+bool Seg4DigitGroup::add(Seg4DigitHC164* display)
+/*
+  Add an initialized display to the group. Returns false when the group
+  is full. The slot length is based on the refresh interval of the first
+  display, all displays use the same refresh rate (see init()).
+*/
+{
+  if (numOfDisplays == MAX_GROUP_DISPLAYS)
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitGroup::add(): group is full."));
+    return false;
+  }
+
+  displays[numOfDisplays] = display;
+  numOfDisplays++;
+
+  slotMicros = ((unsigned long)displays[0]->refreshRateMillis * 1000) / numOfDisplays;
+
+  return true;
+}
+
+void Seg4DigitGroup::loop()
+/*
+  - reads the clock once for all displays.
+  - refreshes one display per time slot, in turns.
+  - updates the state (scrolling, error, etc.) of all displays.
+  - adds the time spent to the cpu time.
+*/
+{
+  unsigned long nowMicros = micros();
+  unsigned long now = millis();
+  int i = 0;
+
+  if (numOfDisplays > 0 && nowMicros - timeStampSlot >= slotMicros)
+  {
+    displays[nextDisplay]->refreshDigit(now, nowMicros);
+
+    // keep the slots on a fixed grid, so the refresh interval of each
+    // display stays equal to number of displays * slot length.
+    // Start a new grid when loop() was called too late for a full slot.
+    timeStampSlot += slotMicros;
+
+    if (nowMicros - timeStampSlot >= slotMicros)
+    {
+      timeStampSlot = nowMicros;
+    }
+
+    nextDisplay++;
+
+    if (nextDisplay == numOfDisplays)
+    {
+      nextDisplay = 0;
+    }
+  }
+
+  for (i = 0; i < numOfDisplays; i++)
+  {
+    displays[i]->updateState(now, nowMicros);
+  }
+
+  cpuTimeMicros += micros() - nowMicros; // measuring only, not passed to the displays.
+  numOfTicks++;
+}
+
+unsigned long Seg4DigitGroup::getCpuTime()
+// total time (microseconds) spent in loop() since the last reset.
+{
+  return cpuTimeMicros;
+}
+
+unsigned long Seg4DigitGroup::getTicks()
+// number of loop() calls since the last reset.
+{
+  return numOfTicks;
+}
+
+void Seg4DigitGroup::resetCpuTime()
+{
+  cpuTimeMicros = 0;
+  numOfTicks = 0;
+}
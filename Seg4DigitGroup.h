@@ -0,0 +1,76 @@
+/*
+  Seg4DigitGroup.h - Scheduler that drives several Seg4DigitHC164
+  displays from one loop() call.
+
+  Every Seg4DigitHC164::loop() reads the clock and keeps its own refresh
+  timestamp, so the refresh moments of several displays drift against
+  each other, and sometimes all displays shift out a symbol at the same
+  moment (peak current).
+
+  The group reads the clock once per loop() call (millis() for the
+  scrolling, error and animation timers, micros() for the time slots and
+  the dimmed on-time) and hands that time to all displays. The refresh
+  interval is divided into one time slot per display. In each slot only
+  one display switches to its next digit, so the shift bursts and digit
+  pin writes of the displays never overlap and are spread evenly over
+  the refresh interval.
+
+  Slot length = refresh interval / number of displays, in microseconds,
+  so number of displays * slot length equals the refresh interval (for
+  example 3 displays at 4 ms: slots of 1333 microseconds). Each display
+  switches digits once per refresh interval, like it does on its own,
+  and the on-time set with setBrightness() stays correct.
+
+  The time spent in loop() is added up, read it with getCpuTime(). This
+  needs one more micros() call at the end of loop(), only for measuring.
+
+  Example:
+    Seg4DigitGroup group;
+    group.add(&display1);
+    group.add(&display2);
+
+    void loop() {
+      group.loop(); // instead of display1.loop() and display2.loop().
+    }
+
+  For study purposes.
+*/
+
+#ifndef SEG4DIGITGROUP_H
+#define SEG4DIGITGROUP_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
+#include "../include/Seg4DigitHC164.h"
+
+#define MAX_GROUP_DISPLAYS 4
+
+class Seg4DigitGroup {
+
+  private:
+    Seg4DigitHC164* displays[MAX_GROUP_DISPLAYS];
+    int numOfDisplays;
+    int nextDisplay;
+
+    // time slot data.
+    unsigned long slotMicros;
+    unsigned long timeStampSlot;
+
+    // cpu time data.
+    unsigned long cpuTimeMicros;
+    unsigned long numOfTicks;
+
+  public:
+    Seg4DigitGroup();
+    bool add(Seg4DigitHC164* display);
+    void loop();
+
+    unsigned long getCpuTime();
+    unsigned long getTicks();
+    void resetCpuTime();
+};
+
+#endif
@@ -1,4 +1,9 @@
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
+#include <limits.h>
 #include "../include/Seg4DigitHC164.h"
 #include "../include/BinarySymbols.h"
 
@@ -63,15 +68,29 @@ void Seg4DigitHC164::init(byte dataPin, byte clockPin, byte* digitPins)
     currentFrame[i] = displaySymbols.zero;
   }
 
-  // initialize current frame copy.
+  // show current frame.
+  frontFrame = currentFrame;
+  frameChanged = true;
+
+  // refresh all digits, including blank digits.
+  skipBlankDigits = false;
+  numOfActiveDigits = 0;
+  currentActiveDigit = 0;
+
+  // initialize error frame: 'Err'.
   for (i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
   {
-    currentFrameCopy[i] = displaySymbols.zero;
+    errorFrame[i] = displaySymbols.blank;
   }
 
+  errorFrame[0] = displaySymbols.letter_E;
+  errorFrame[1] = displaySymbols.letter_r;
+  errorFrame[2] = displaySymbols.letter_r;
+
   // initialize variables used for scrolling.
   scrolling = false;
   numOfscrollingFrames = 0;
+  scrollingBuffer = displayBuffer;
   scrollingInterval = 300; // milliseconds between frames.
   currentScrollingFrame = 0;
   timeStampFrame = 0;
@@ -86,8 +105,63 @@ void Seg4DigitHC164::init(byte dataPin, byte clockPin, byte* digitPins)
   refreshRate = 250; // Hz.
   refreshRateMillis = 1000 / refreshRate;
 
+  // initialize variables used for value streaming.
+  streaming = false;
+  streamPolicy = 'l';
+  streamDecimalPlaces = 0;
+  streamHysteresis = 0;
+  streamIntervalMillis = 0;
+  timeStampStream = 0;
+  streamCount = 0;
+  streamValueShown = false;
+
+  // initialize level display mode.
+  levelMode = 'h';
+
+  // initialize variables used for animations.
+  animating = false;
+  animationMode = 'o';
+  animationFrames = NULL;
+  animationFrame = NULL;
+  numOfAnimationFrames = 0;
+  currentAnimationFrame = 0;
+  animationDirection = 1;
+  animationFrameDuration = 0;
+  timeStampAnimation = 0;
+
+  // initialize brightness (full).
+  brightness = 255;
+  digitOnTimeMicros = (unsigned long)refreshRateMillis * 1000;
+  timeStampDigitOn = 0;
+  digitOn = false;
+
+  // initialize variables used for the serial protocol.
+  serialStream = NULL;
+  serialState = 's';
+  serialFramesAccepted = 0;
+  serialFramesRejected = 0;
+
+  // initialize carousel pages (empty, blank display).
+  for (i = 0; i < NUM_OF_CAROUSEL_PAGES; i++)
+  {
+    for (int j = 0; j < BUFFER_LENGTH; j++)
+    {
+      carouselPages[i].buffer[j] = displaySymbols.blank;
+    }
+    carouselPages[i].numOfScrollingFrames = 0;
+    carouselPages[i].type = ' ';
+    carouselPages[i].dwell = 0;
+  }
+
+  carouselRunning = false;
+  numOfCarouselPages = 0;
+  currentPage = 0;
+  timeStampPage = 0;
+
+#if SEG4DIGIT_DEBUG
   // debug.
   Serial.print(F("BUFFER_LENGTH: "));Serial.println(BUFFER_LENGTH);
+#endif
 }
 
 void Seg4DigitHC164::loop()
@@ -95,41 +169,26 @@ void Seg4DigitHC164::loop()
   - alternates between the digits.
   - overrides output with error message (if necessary).
   - calls scrolling loop method (if necessary).
+  - moves to the next animation frame (if necessary).
+  - switches off the digit early when dimmed (if necessary).
+  - parses serial protocol frames (if a stream is attached).
+
+  When the display is part of a Seg4DigitGroup, don't call this
+  method, the group calls refreshDigit() and updateState() instead.
 */
 {
-  if (millis() - timeStampDigit >= refreshRateMillis)
-  // quickly alternate between digits, using the refresh rate set in init().
-  {
-    previousDigit = currentDigit; // used to switch off the previous digit.
-    currentDigit++;
-
-    if (currentDigit == NUM_OF_DISPLAY_DIGITS)
-    {
-      // currentDigit is zero indexed. So when currendDigit equals 
-      // the number of display digits, the index is pointing one 
-      // digit 'outside' of the available display digits and should
-      // be reset to index 0.
-      
-      currentDigit = 0;
-    }
+  // read the clock once: millis() for the refresh and state timers,
+  // micros() for the on-time of a dimmed digit.
+  unsigned long now = millis();
+  unsigned long nowMicros = micros();
 
-    digitalWrite(_digitPins[previousDigit], 0);
-    digitalWrite(_digitPins[currentDigit], 1);
-    shiftOut(_dataPin, _clockPin, LSBFIRST, currentFrame[currentDigit]);
-    timeStampDigit = millis();
-  }
-  
-  if (errorShown) // error overrides scrolling.
+  if (now - timeStampDigit >= refreshRateMillis)
+  // quickly alternate between digits, using the refresh rate set in init().
   {
-    if (millis() - timeStampError > errorDuration)
-    {
-      removeError();
-    }
-  }
-  else if (scrolling) // call looping method that updates frames.
-  {   
-    updateScrollingFrame();
+    refreshDigit(now, nowMicros);
   }
+
+  updateState(now, nowMicros);
 }
 
 void Seg4DigitHC164::showInt(int input)
@@ -137,7 +196,7 @@ void Seg4DigitHC164::showInt(int input)
 { 
   currentInputInt = input;
   buildInputBuffer('i');
-  buildDisplayBuffer();
+  buildDisplayBuffer(displayBuffer);
   processDisplayBuffer();
 }
 
@@ -152,7 +211,7 @@ void Seg4DigitHC164::showFloat(float input, int decimalPlaces)
   // (index of rightmost character = inputLength - 1).
 
   int pointIndex = (getInputLength() - 1) - decimalPlaces;
-  buildDisplayBuffer(pointIndex);
+  buildDisplayBuffer(displayBuffer, pointIndex);
   processDisplayBuffer();
 }
 
@@ -161,26 +220,327 @@ void Seg4DigitHC164::showHex(unsigned long input)
 { 
   currentInputLong = input;
   buildInputBuffer('h');
-  buildDisplayBuffer();
+  buildDisplayBuffer(displayBuffer);
   processDisplayBuffer();
 }
 
 void Seg4DigitHC164::showError()
-// Store current frame in copy, temporarily set current frame to 'err'.
+// Temporarily show the error frame ('Err') instead of the front frame.
 {
   timeStampError = millis();
+  errorShown = true;
+  frameChanged = true;
+}
 
-  for (int i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+void Seg4DigitHC164::showText(const char* input)
+/*
+  Show a text, using the chars supported by BinarySymbols. Texts that
+  are longer than the display will scroll, texts longer than the
+  maximum input length are cut off.
+*/
+{
+  int i = 0;
+
+  for (i = 0; i < maxInputLength && input[i] != '\0'; i++)
   {
-    currentFrameCopy[i] = currentFrame[i];
+    inputBuffer[i] = input[i];
   }
 
-  currentFrame[0] = displaySymbols.letter_E;
-  currentFrame[1] = displaySymbols.letter_r;
-  currentFrame[2] = displaySymbols.letter_r;
-  currentFrame[3] = displaySymbols.blank;
+  inputBuffer[i] = '\0';
+  currentInputLength = i;
 
-  errorShown = true;
+  buildDisplayBuffer(displayBuffer);
+  processDisplayBuffer();
+}
+
+void Seg4DigitHC164::setBrightness(byte level)
+// set brightness, 0 (off) - 255 (full). Dims by shortening the on-time of each digit.
+{
+  brightness = level;
+  digitOnTimeMicros = ((unsigned long)refreshRateMillis * 1000 * level) / 255;
+}
+
+void Seg4DigitHC164::setBlankSkipping(bool skip)
+// when true, blank digits are skipped in the refresh cycle (see notes in header).
+{
+  skipBlankDigits = skip;
+  frameChanged = true;
+}
+
+void Seg4DigitHC164::setStreamMode(char policy, int updateRate, int decimalPlaces, float hysteresis)
+/*
+  Enable value streaming. Values handed to push() are accumulated and
+  committed to the display updateRate times per second.
+  policy: 'l' last, 'n' minimum, 'x' maximum, 'm' mean.
+  hysteresis: minimum change (in display units, steps of the last digit)
+  needed to update the display.
+*/
+{
+  if (updateRate <= 0)
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::setStreamMode(): invalid update rate."));
+    return;
+  }
+
+  streamPolicy = policy;
+  streamDecimalPlaces = decimalPlaces;
+  streamHysteresis = hysteresis;
+
+  // convert display units to value units: 1 unit = 10^-decimalPlaces.
+  for (int i = 0; i < decimalPlaces; i++)
+  {
+    streamHysteresis /= 10;
+  }
+  streamIntervalMillis = 1000 / updateRate;
+  timeStampStream = millis();
+  streamCount = 0;
+  streamValueShown = false;
+  streaming = true;
+}
+
+void Seg4DigitHC164::stopStream()
+// disable value streaming, the last committed value stays on the display.
+{
+  streaming = false;
+  streamCount = 0;
+}
+
+void Seg4DigitHC164::push(float input)
+// accumulate a stream value. No formatting is done here, see updateStream().
+{
+  if (streamCount == 0)
+  {
+    streamSum = input;
+    streamMin = input;
+    streamMax = input;
+  }
+  else
+  {
+    streamSum += input;
+    if (input < streamMin) streamMin = input;
+    if (input > streamMax) streamMax = input;
+  }
+
+  streamLast = input;
+  streamCount++;
+}
+
+void Seg4DigitHC164::setLevelMode(char mode)
+// set the bar graph mode used by showLevel(): 'h' horizontal, 'v' vertical.
+{
+  if (mode != 'h' && mode != 'v')
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::setLevelMode(): unknown mode."));
+    return;
+  }
+
+  levelMode = mode;
+}
+
+void Seg4DigitHC164::showLevel(int value, int max)
+/*
+  Show value as a bar graph, relative to max. The number of filled
+  steps is calculated with integer arithmetic and looked up in the
+  level tables of BinarySymbols, no formatting is needed.
+*/
+{
+  int i = 0;
+  int steps;
+  int fill;
+
+  if (max <= 0)
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::showLevel(): max should be larger than 0."));
+    return;
+  }
+
+  // clip value to the range 0 - max.
+  if (value < 0) value = 0;
+  if (value > max) value = max;
+
+  scrolling = false;
+  frontFrame = currentFrame;
+  frameChanged = true;
+
+  if (levelMode == 'v')
+  {
+    // 3 steps, every digit shows the same fill level.
+    steps = ((long)value * 3) / max;
+
+    for (i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+    {
+      currentFrame[i] = displaySymbols.levelVertical[steps];
+    }
+  }
+  else
+  {
+    // 2 steps per digit, filled from left to right.
+    steps = ((long)value * 2 * NUM_OF_DISPLAY_DIGITS) / max;
+
+    for (i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+    {
+      fill = steps - (2 * i);
+      if (fill < 0) fill = 0;
+      if (fill > 2) fill = 2;
+      currentFrame[i] = displaySymbols.levelHorizontal[fill];
+    }
+  }
+}
+
+void Seg4DigitHC164::playAnimation(const AnimationFrame* frames, int numOfFrames, char mode)
+/*
+  Start playing an animation table stored in flash memory (PROGMEM).
+  mode: 'l' loop, 'o' one-shot, 'p' ping-pong.
+*/
+{
+  if (frames == NULL || numOfFrames <= 0)
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::playAnimation(): empty animation."));
+    return;
+  }
+
+  if (mode != 'l' && mode != 'o' && mode != 'p')
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::playAnimation(): unknown mode."));
+    return;
+  }
+
+  animationFrames = frames;
+  numOfAnimationFrames = numOfFrames;
+  animationMode = mode;
+  currentAnimationFrame = 0;
+  animationFrame = animationFrames;
+  animationDirection = 1;
+  animationFrameDuration = pgm_read_word(&animationFrame->duration);
+  timeStampAnimation = millis();
+  animating = true;
+  frameChanged = true;
+}
+
+void Seg4DigitHC164::stopAnimation()
+// stop the animation, the display shows the current value again.
+{
+  animating = false;
+  frameChanged = true;
+}
+
+bool Seg4DigitHC164::isAnimating()
+{
+  return animating;
+}
+
+void Seg4DigitHC164::attachSerial(Stream* stream)
+// parse serial protocol frames from stream in loop(). NULL detaches the stream.
+{
+  serialStream = stream;
+  serialState = 's';
+}
+
+unsigned long Seg4DigitHC164::getSerialFramesAccepted()
+{
+  return serialFramesAccepted;
+}
+
+unsigned long Seg4DigitHC164::getSerialFramesRejected()
+{
+  return serialFramesRejected;
+}
+
+void Seg4DigitHC164::setPageInt(int page, int input)
+// pre-render an int on a carousel page, only when the value has changed.
+{
+  if (!isValidPage(page)) return;
+
+  CarouselPage* target = &carouselPages[page];
+
+  if (target->type == 'i' && target->valueLong == input)
+  {
+    return; // already rendered.
+  }
+
+  target->type = 'i';
+  target->valueLong = input;
+  renderPage(page);
+}
+
+void Seg4DigitHC164::setPageFloat(int page, float input, int decimalPlaces)
+// pre-render a float on a carousel page, only when the value has changed.
+{
+  if (!isValidPage(page)) return;
+
+  CarouselPage* target = &carouselPages[page];
+
+  if (target->type == 'f' && target->valueFloat == input && target->decimalPlaces == decimalPlaces)
+  {
+    return; // already rendered.
+  }
+
+  target->type = 'f';
+  target->valueFloat = input;
+  target->decimalPlaces = decimalPlaces;
+  renderPage(page);
+}
+
+void Seg4DigitHC164::setPageHex(int page, unsigned long input)
+// pre-render a hexadecimal value on a carousel page, only when the value has changed.
+{
+  if (!isValidPage(page)) return;
+
+  CarouselPage* target = &carouselPages[page];
+
+  if (target->type == 'h' && (unsigned long)target->valueLong == input)
+  {
+    return; // already rendered.
+  }
+
+  target->type = 'h';
+  target->valueLong = input;
+  renderPage(page);
+}
+
+void Seg4DigitHC164::setPageDwell(int page, unsigned int dwellMillis)
+// set how long (milliseconds) a page is shown before switching to the next page.
+{
+  if (!isValidPage(page)) return;
+
+  carouselPages[page].dwell = dwellMillis;
+}
+
+void Seg4DigitHC164::startCarousel(int numOfPages, unsigned int dwellMillis)
+/*
+  Rotate through pages 0 to numOfPages - 1. Every page is shown for
+  dwellMillis milliseconds, use setPageDwell() afterwards to change the
+  dwell time of a single page.
+*/
+{
+  if (numOfPages <= 0 || numOfPages > NUM_OF_CAROUSEL_PAGES)
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::startCarousel(): invalid number of pages."));
+    return;
+  }
+
+  for (int i = 0; i < numOfPages; i++)
+  {
+    carouselPages[i].dwell = dwellMillis;
+  }
+
+  numOfCarouselPages = numOfPages;
+  currentPage = 0;
+  timeStampPage = millis();
+  carouselRunning = true;
+  showPage(currentPage);
+}
+
+void Seg4DigitHC164::stopCarousel()
+// stop rotating, the current page stays on the display.
+{
+  carouselRunning = false;
 }
 
 
@@ -191,13 +551,152 @@ void Seg4DigitHC164::showError()
   -----------------
 */
 
+void Seg4DigitHC164::refreshDigit(unsigned long now, unsigned long nowMicros)
+// switch off the previous digit, switch on the next digit and shift out its symbol.
+{
+  bool changed = frameChanged;
+
+  if (skipBlankDigits)
+  {
+    if (frameChanged)
+    {
+      buildActiveDigits();
+    }
+
+    if (numOfActiveDigits == 0) // blank display, nothing to refresh.
+    {
+      digitalWrite(_digitPins[currentDigit], 0);
+      digitOn = false;
+      timeStampDigit = now;
+      return;
+    }
+
+    previousDigit = currentDigit;
+    currentActiveDigit++;
+
+    if (currentActiveDigit >= numOfActiveDigits)
+    {
+      currentActiveDigit = 0;
+    }
+
+    currentDigit = activeDigits[currentActiveDigit];
+
+    if (currentDigit == previousDigit && digitOn && !changed)
+    {
+      // only one digit is lit and its symbol is already shifted out.
+      timeStampDigit = now;
+      return;
+    }
+  }
+  else
+  {
+    previousDigit = currentDigit; // used to switch off the previous digit.
+    currentDigit++;
+
+    if (currentDigit == NUM_OF_DISPLAY_DIGITS)
+    {
+      // currentDigit is zero indexed. So when currendDigit equals 
+      // the number of display digits, the index is pointing one 
+      // digit 'outside' of the available display digits and should
+      // be reset to index 0.
+      
+      currentDigit = 0;
+    }
+  }
+
+  digitalWrite(_digitPins[previousDigit], 0);
+  digitalWrite(_digitPins[currentDigit], 1);
+  shiftOut(_dataPin, _clockPin, LSBFIRST, getSymbol(currentDigit));
+  timeStampDigit = now;
+  timeStampDigitOn = nowMicros;
+  digitOn = true;
+}
+
+byte Seg4DigitHC164::getSymbol(byte digit)
+// symbol currently shown on a digit: error, animation frame or front frame.
+{
+  if (errorShown) // error overrides everything else.
+  {
+    return errorFrame[digit];
+  }
+  else if (animating)
+  {
+    // read symbol straight from the animation table in flash memory.
+    return pgm_read_byte(&animationFrame->symbols[digit]);
+  }
+  else
+  {
+    return frontFrame[digit];
+  }
+}
+
+void Seg4DigitHC164::buildActiveDigits()
+// list the digits that are not blank, only these are refreshed when skipping blank digits.
+{
+  numOfActiveDigits = 0;
+
+  for (byte i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+  {
+    if (getSymbol(i) != displaySymbols.blank)
+    {
+      activeDigits[numOfActiveDigits] = i;
+      numOfActiveDigits++;
+    }
+  }
+
+  frameChanged = false;
+}
+
+void Seg4DigitHC164::updateState(unsigned long now, unsigned long nowMicros)
+// everything loop() does besides refreshing the digits, using 'now' (and 'nowMicros') as current time.
+{
+  if (brightness < 255 && digitOn) // switch off digit when its on-time has passed.
+  {
+    updateBrightness(nowMicros);
+  }
+  
+  if (errorShown) // error overrides scrolling.
+  {
+    if (now - timeStampError > errorDuration)
+    {
+      removeError();
+    }
+  }
+  else if (scrolling) // call looping method that updates frames.
+  {   
+    updateScrollingFrame(now);
+  }
+
+  if (streaming) // commit accumulated stream values at the update rate.
+  {
+    updateStream(now);
+  }
+
+  if (animating) // move to the next animation frame when it's time.
+  {
+    updateAnimation(now);
+  }
+
+  if (carouselRunning) // switch to the next page when its dwell time has passed.
+  {
+    updateCarousel(now);
+  }
+
+  if (serialStream != NULL) // parse incoming serial protocol frames.
+  {
+    processSerial();
+  }
+}
+
 void Seg4DigitHC164::buildInputBuffer(char outputType, int decimalPlaces) 
 // write input to input buffer, using the specified output formatting.
 // i int, f float, h hex.
 // decimalPlaces = 0 by default (only needed for ouput type float).
 {
   int writtenChars = -1;
+#if SEG4DIGIT_DEBUG
   Serial.print("outputType: ");Serial.println(outputType);
+#endif
 
   switch (outputType)
   {
@@ -222,8 +721,10 @@ void Seg4DigitHC164::buildInputBuffer(char outputType, int decimalPlaces)
   // store current input length.
   currentInputLength = getInputLength();
 
+#if SEG4DIGIT_DEBUG
   // debug
   Serial.print(F("buildInputBuffer() writtenChars: "));Serial.println(writtenChars);
+#endif
 
   if (writtenChars < 0)
   {
@@ -232,8 +733,9 @@ void Seg4DigitHC164::buildInputBuffer(char outputType, int decimalPlaces)
   }
 }
 
-void Seg4DigitHC164::buildDisplayBuffer(int pointIndex)
-// convert inputBuffer (char array) to displayBuffer (bytes representing display symbols).
+void Seg4DigitHC164::buildDisplayBuffer(byte* buffer, int pointIndex)
+// convert inputBuffer (char array) to buffer (bytes representing display symbols),
+// the displayBuffer or the scratch buffer of a carousel page.
 // pointIndex = -1 by default, only needed when displaying a float.
 {
   int i = 0;
@@ -243,16 +745,16 @@ void Seg4DigitHC164::buildDisplayBuffer(int pointIndex)
   for (i = 0; i < currentInputLength; i++)
   {
     charToConvert = inputBuffer[i];
-    displayBuffer[i] = displaySymbols.convertCharToSymbol(charToConvert);
+    buffer[i] = displaySymbols.convertCharToSymbol(charToConvert);
   }
 
-  displayBuffer[currentInputLength] = '\0'; // add null terminator.
+  buffer[currentInputLength] = '\0'; // add null terminator.
 
   if (pointIndex >= 0) // if input type is float.
   {
     // add decimal point to the digit at the specified index.
-    byte digitWithPoint = displaySymbols.addDot(displayBuffer[pointIndex]);
-    displayBuffer[pointIndex] = digitWithPoint;
+    byte digitWithPoint = displaySymbols.addDot(buffer[pointIndex]);
+    buffer[pointIndex] = digitWithPoint;
   }
 }
 
@@ -261,21 +763,26 @@ void Seg4DigitHC164::processDisplayBuffer()
 {
   if (currentInputLength > NUM_OF_DISPLAY_DIGITS)
   {
-    buildScrollingBuffer();
+    numOfscrollingFrames = buildScrollingBuffer(displayBuffer, displayBuffer);
+    scrollingBuffer = displayBuffer;
+    currentScrollingFrame = 0;
     scrolling = true;
   }
   else if (currentInputLength >= 0 && currentInputLength <= NUM_OF_DISPLAY_DIGITS)
   {
-    updateCurrentFrame();
+    buildFrame(currentFrame, displayBuffer);
+    frontFrame = currentFrame;
+    frameChanged = true;
     scrolling = false;
   }
 }
 
-void Seg4DigitHC164::updateCurrentFrame()
+void Seg4DigitHC164::buildFrame(byte* frame, const byte* source)
 /*
-    Update the current value the display is showing. If the input length
-    is lower than the number of display digits, add blank spaces to
-    the left.
+    Copy the symbols in source (the display buffer or the scratch buffer
+    of a carousel page) to frame (the current frame or a carousel page).
+    If the input length is lower than the number of display digits, add
+    blank spaces to the left.
 */
 {
   int i = 0;
@@ -286,7 +793,7 @@ void Seg4DigitHC164::updateCurrentFrame()
   {
     for (i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
     {
-      currentFrame[i] = displayBuffer[i];
+      frame[i] = source[i];
     }
   }
   else // add blank spaces to the left.
@@ -299,9 +806,9 @@ void Seg4DigitHC164::updateCurrentFrame()
       }
       else // insert symbol from display buffer, adjust index (move to right).
       {
-        input = displayBuffer[i - blankSpaces];
+        input = source[i - blankSpaces];
       }
-      currentFrame[i] = input;
+      frame[i] = input;
     }
   }
 
@@ -344,8 +851,13 @@ void Seg4DigitHC164::updateCurrentFrame()
   */
 }
 
-void Seg4DigitHC164::buildScrollingBuffer()
-// add blank spaces to displayBuffer needed for animation effect.
+int Seg4DigitHC164::buildScrollingBuffer(byte* buffer, const byte* source)
+/*
+    Copy the symbols in source to buffer (source and buffer can be the
+    same, like the display buffer) and add the blank spaces needed for
+    the animation effect. Returns the number of frames in the scrolling
+    animation.
+*/
 {
   int i = 0;
 
@@ -357,62 +869,443 @@ void Seg4DigitHC164::buildScrollingBuffer()
   byte inputCopy[currentInputLength];
   for (i = 0; i < currentInputLength; i++)
   {
-    inputCopy[i] = displayBuffer[i];
+    inputCopy[i] = source[i];
   }
 
-  // add blank spaces at the beginning of display buffer.
+  // add blank spaces at the beginning of the buffer.
   for (i = 0; i < spacesBefore; i++)
   {
-    displayBuffer[i] = displaySymbols.blank;
+    buffer[i] = displaySymbols.blank;
   }
 
   // add input from copy.
   for (i; i < scrollingLength - spacesAfter; i++)
   {
-    displayBuffer[i] = inputCopy[i - spacesBefore];
+    buffer[i] = inputCopy[i - spacesBefore];
   }
 
   // add ending spaces.
   for (i; i < scrollingLength; i++)
   {
-    displayBuffer[i] = displaySymbols.blank;
+    buffer[i] = displaySymbols.blank;
   }
 
-  // calculate number of frames in the scrolling animation.
-  numOfscrollingFrames = scrollingLength - NUM_OF_DISPLAY_DIGITS + 1;
+  // number of frames in the scrolling animation.
+  return scrollingLength - NUM_OF_DISPLAY_DIGITS + 1;
 }
 
-void Seg4DigitHC164::updateScrollingFrame()
+void Seg4DigitHC164::updateScrollingFrame(unsigned long now)
+// point the front frame to the next frame of the scrolling buffer.
 {
-  if (millis() - timeStampFrame >= scrollingInterval)
+  if (now - timeStampFrame >= scrollingInterval)
   {
-    int i = 0;
+    frontFrame = scrollingBuffer + currentScrollingFrame;
+    frameChanged = true;
 
-    for (i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+    timeStampFrame = now;
+
+    currentScrollingFrame++;
+
+    if (currentScrollingFrame >= numOfscrollingFrames)
     {
-      currentFrame[i] = displayBuffer[i + currentScrollingFrame];
+      currentScrollingFrame = 0;
     }
+  }
+}
 
-    timeStampFrame = millis();
+void Seg4DigitHC164::updateStream(unsigned long now)
+// commit the accumulated stream value to the display, using the stream policy.
+{
+  if (now - timeStampStream < streamIntervalMillis)
+  {
+    return;
+  }
 
-    currentScrollingFrame++;
+  timeStampStream = now;
+
+  if (streamCount == 0) // nothing pushed since the last commit.
+  {
+    return;
+  }
+
+  float value;
+
+  switch (streamPolicy)
+  {
+    case 'n':
+      value = streamMin;
+      break;
+    case 'x':
+      value = streamMax;
+      break;
+    case 'm':
+      value = streamSum / streamCount;
+      break;
+    case 'l':
+    default:
+      value = streamLast;
+      break;
+  }
+
+  streamCount = 0;
+
+  if (streamValueShown && fabs(value - streamShownValue) < streamHysteresis)
+  {
+    // change is too small, keep showing the previous value.
+    return;
+  }
+
+  // the shown value must fit in a long, after moving the decimal places
+  // to the left of the decimal point (see convertFloatToLong()).
+  float limit = LONG_MAX;
+  float halfStep = 0.5; // half a step of the last shown digit.
+
+  for (int i = 0; i < streamDecimalPlaces; i++)
+  {
+    limit /= 10;
+    halfStep /= 10;
+  }
+
+  if (!(fabs(value) < limit))
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164::updateStream(): value out of range."));
+    showError();
+    return;
+  }
+
+  streamShownValue = value;
+  streamValueShown = true;
 
-    if (currentScrollingFrame == numOfscrollingFrames)
+  // round to the nearest step of the last digit, convertFloatToLong() truncates.
+  currentInputFloat = value >= 0 ? value + halfStep : value - halfStep;
+  buildInputBuffer('f', streamDecimalPlaces);
+
+  if (streamDecimalPlaces > 0)
+  {
+    buildDisplayBuffer(displayBuffer, (currentInputLength - 1) - streamDecimalPlaces);
+  }
+  else // whole number, no decimal point.
+  {
+    buildDisplayBuffer(displayBuffer);
+  }
+
+  processDisplayBuffer();
+}
+
+void Seg4DigitHC164::updateAnimation(unsigned long now)
+// move to the next animation frame, using the playback mode.
+{
+  if (now - timeStampAnimation < animationFrameDuration)
+  {
+    return;
+  }
+
+  timeStampAnimation = now;
+
+  int nextFrame = currentAnimationFrame + animationDirection;
+
+  if (nextFrame < 0 || nextFrame >= numOfAnimationFrames)
+  {
+    // passed the first or last frame.
+    switch (animationMode)
     {
-      currentScrollingFrame = 0;
+      case 'l':
+        nextFrame = 0;
+        break;
+      case 'p':
+        animationDirection = -animationDirection;
+        nextFrame = currentAnimationFrame + animationDirection;
+        if (nextFrame < 0 || nextFrame >= numOfAnimationFrames)
+        {
+          nextFrame = currentAnimationFrame; // animation has only one frame.
+        }
+        break;
+      case 'o':
+      default:
+        animating = false;
+        frameChanged = true;
+        return;
     }
   }
+
+  // swap the frame pointer, the frame itself stays in flash memory.
+  currentAnimationFrame = nextFrame;
+  animationFrame = animationFrames + currentAnimationFrame;
+  frameChanged = true;
+  animationFrameDuration = pgm_read_word(&animationFrame->duration);
 }
 
-void Seg4DigitHC164::removeError()
-// restores current frame to the value before the error message.
+void Seg4DigitHC164::updateBrightness(unsigned long nowMicros)
+// switch off the current digit when the dimmed on-time has passed.
+{
+  if (nowMicros - timeStampDigitOn >= digitOnTimeMicros)
+  {
+    digitalWrite(_digitPins[currentDigit], 0);
+    digitOn = false;
+  }
+}
+
+void Seg4DigitHC164::processSerial()
+/*
+  Parse the available serial bytes, one state per frame field:
+  's' sync, 't' type, 'l' length, 'p' payload, 'c' checksum.
+  Reads at most SERIAL_MAX_BYTES_PER_LOOP bytes, so loop() never blocks.
+*/
+{
+  int bytesRead = 0;
+  byte input;
+
+  while (bytesRead < SERIAL_MAX_BYTES_PER_LOOP && serialStream->available() > 0)
+  {
+    input = serialStream->read();
+    bytesRead++;
+
+    switch (serialState)
+    {
+      case 's':
+        if (input == SERIAL_SYNC) serialState = 't';
+        break;
+      case 't':
+        serialType = input;
+        serialChecksum = input;
+        serialState = 'l';
+        break;
+      case 'l':
+        if (input > SERIAL_MAX_PAYLOAD)
+        {
+          // frame does not fit, wait for the next sync byte.
+          serialFramesRejected++;
+          serialState = 's';
+          break;
+        }
+        serialLength = input;
+        serialIndex = 0;
+        serialChecksum ^= input;
+        serialState = (serialLength > 0) ? 'p' : 'c';
+        break;
+      case 'p':
+        // copy payload straight into the back frame.
+        serialPayload[serialIndex++] = input;
+        serialChecksum ^= input;
+        if (serialIndex == serialLength) serialState = 'c';
+        break;
+      case 'c':
+        if (input == serialChecksum && processSerialFrame())
+        {
+          serialFramesAccepted++;
+        }
+        else
+        {
+          serialFramesRejected++;
+        }
+        serialState = 's';
+        break;
+      default:
+        serialState = 's';
+        break;
+    }
+  }
+}
+
+bool Seg4DigitHC164::processSerialFrame()
+// apply a complete frame with a valid checksum. Returns false for invalid frames.
 {
-  for (int i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+  int i = 0;
+
+  switch (serialType)
   {
-    currentFrame[i] = currentFrameCopy[i];
+    case SERIAL_TYPE_SEGMENTS:
+      if (serialLength != NUM_OF_DISPLAY_DIGITS) return false;
+      for (i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+      {
+        currentFrame[i] = serialPayload[i];
+      }
+      scrolling = false;
+      frontFrame = currentFrame;
+      frameChanged = true;
+      return true;
+
+    case SERIAL_TYPE_VALUE:
+      {
+        if (serialLength != 6) return false;
+
+        // value: 4 bytes little endian, after format and decimal places.
+        unsigned long value = (unsigned long)serialPayload[2] |
+          ((unsigned long)serialPayload[3] << 8) |
+          ((unsigned long)serialPayload[4] << 16) |
+          ((unsigned long)serialPayload[5] << 24);
+
+        switch (serialPayload[0])
+        {
+          case 'i':
+            {
+              long input = (int32_t)value;
+
+              // int can be 16 bits (AVR), reject values that don't fit.
+              if (input < INT_MIN || input > INT_MAX) return false;
+
+              showInt((int)input);
+              return true;
+            }
+          case 'f':
+            {
+              float input;
+              int decimalPlaces = serialPayload[1];
+              memcpy(&input, &serialPayload[2], sizeof(input)); // little endian float32.
+
+              if (decimalPlaces > maxInputLength) return false;
+
+              // the value times 10^decimalPlaces has to fit in a long (also rejects nan and inf).
+              float limit = LONG_MAX;
+              for (int i = 0; i < decimalPlaces; i++)
+              {
+                limit /= 10;
+              }
+              if (!(fabs(input) < limit)) return false;
+
+              showFloat(input, decimalPlaces);
+              return true;
+            }
+          case 'h':
+            showHex(value);
+            return true;
+          default:
+            return false;
+        }
+      }
+
+    case SERIAL_TYPE_BRIGHTNESS:
+      if (serialLength != 1) return false;
+      setBrightness(serialPayload[0]);
+      return true;
+
+    case SERIAL_TYPE_TEXT:
+      serialPayload[serialLength] = '\0';
+      showText((const char*)serialPayload);
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void Seg4DigitHC164::updateCarousel(unsigned long now)
+// switch to the next carousel page when the dwell time of the current page has passed.
+{
+  if (now - timeStampPage < carouselPages[currentPage].dwell)
+  {
+    return;
   }
 
+  timeStampPage = now;
+  currentPage++;
+
+  if (currentPage == numOfCarouselPages)
+  {
+    currentPage = 0;
+  }
+
+  showPage(currentPage);
+}
+
+void Seg4DigitHC164::showPage(int page)
+// point the front frame (or the scrolling buffer) to a pre-rendered page.
+{
+  CarouselPage* source = &carouselPages[page];
+
+  if (source->numOfScrollingFrames > 0)
+  {
+    scrollingBuffer = source->buffer;
+    numOfscrollingFrames = source->numOfScrollingFrames;
+    currentScrollingFrame = 0;
+    timeStampFrame = 0; // show the first scrolling frame at the next update.
+    scrolling = true;
+  }
+  else
+  {
+    frontFrame = source->buffer;
+    frameChanged = true;
+    scrolling = false;
+  }
+}
+
+void Seg4DigitHC164::renderPage(int page)
+/*
+  Format the value of a carousel page and store it in the page: a frame,
+  or a scrolling buffer when the input is longer than the display. The
+  symbols are converted in a scratch buffer, so the display buffer (and
+  the input length) of a scrolling show*() value are not changed. When
+  the page is on the display (also after stopCarousel()), it is shown
+  again so the new value becomes visible.
+*/
+{
+  CarouselPage* target = &carouselPages[page];
+  byte pageBuffer[BUFFER_LENGTH];
+  int shownInputLength = currentInputLength;
+  int pointIndex = -1;
+
+  switch (target->type)
+  {
+    case 'i':
+      currentInputInt = target->valueLong;
+      buildInputBuffer('i');
+      break;
+    case 'f':
+      currentInputFloat = target->valueFloat;
+      buildInputBuffer('f', target->decimalPlaces);
+      pointIndex = (currentInputLength - 1) - target->decimalPlaces;
+      break;
+    case 'h':
+      currentInputLong = target->valueLong;
+      buildInputBuffer('h');
+      break;
+    default:
+      return;
+  }
+
+  buildDisplayBuffer(pageBuffer, pointIndex);
+
+  if (currentInputLength > NUM_OF_DISPLAY_DIGITS)
+  {
+    // render into the page only, the scrolling state on the display is not changed.
+    target->numOfScrollingFrames = buildScrollingBuffer(target->buffer, pageBuffer);
+  }
+  else
+  {
+    buildFrame(target->buffer, pageBuffer);
+    target->numOfScrollingFrames = 0;
+  }
+
+  currentInputLength = shownInputLength;
+
+  // the page can still be on the display after stopCarousel(), so check
+  // the frame pointers instead of the current page.
+  bool pageShown = scrolling ? scrollingBuffer == target->buffer : frontFrame == target->buffer;
+
+  if (pageShown) // show the page again: new frame count, and the active digits are rebuilt.
+  {
+    showPage(page);
+  }
+}
+
+bool Seg4DigitHC164::isValidPage(int page)
+{
+  if (page < 0 || page >= NUM_OF_CAROUSEL_PAGES)
+  {
+    // debug
+    Serial.println(F("error in Seg4DigitHC164: invalid carousel page."));
+    return false;
+  }
+
+  return true;
+}
+
+void Seg4DigitHC164::removeError()
+// show the front frame again.
+{
   errorShown = false;
+  frameChanged = true;
 }
 
 long Seg4DigitHC164::convertFloatToLong(int decimalPlaces)
@@ -444,8 +1337,10 @@ int Seg4DigitHC164::getInputLength()
     {
       inputLength = i; // null terminator index equals input length.
 
+#if SEG4DIGIT_DEBUG
       // debug
       Serial.print(F("getInputLength() inputLength: "));Serial.println(inputLength);
+#endif
       
       break;
     }
@@ -18,11 +18,33 @@
 #ifndef SEG4DIGITHC164_H
 #define SEG4DIGITHC164_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include "../include/VirtualMCU.h"
+#endif
 
 #define NUM_OF_DISPLAY_DIGITS 4
 #define BUFFER_LENGTH 16
 
+// serial protocol, see notes below.
+#define SERIAL_SYNC 0xA5
+#define SERIAL_TYPE_SEGMENTS 0x01
+#define SERIAL_TYPE_VALUE 0x02
+#define SERIAL_TYPE_BRIGHTNESS 0x03
+#define SERIAL_TYPE_TEXT 0x04
+#define SERIAL_MAX_PAYLOAD BUFFER_LENGTH
+#define SERIAL_MAX_BYTES_PER_LOOP 32
+
+#define NUM_OF_CAROUSEL_PAGES 4
+
+// 1 = print debug messages to Serial while formatting values. Keep 0 when
+// Serial is attached with attachSerial(): the messages would go back over
+// the link, and Serial.print() blocks when its transmit buffer is full.
+#ifndef SEG4DIGIT_DEBUG
+#define SEG4DIGIT_DEBUG 0
+#endif
+
 /*
   NOTES ABOUT NUMBER OF DIGITS:
 
@@ -96,9 +118,182 @@
   all the 'bits' are constantly being 'shoved through' the whole display.
 */
 
+/*
+  NOTES ABOUT SKIPPING BLANK DIGITS:
+
+  Short values are padded with blank digits on the left. Normally every
+  digit gets an equal part of the refresh cycle, so a 1-digit value is
+  only lit 1/4 of the time on a 4-digit display, and the blank digits
+  still cost a shiftOut() and two digitalWrite() calls each.
+
+  With setBlankSkipping(true), a list of the digits that are not blank
+  is made whenever the shown frame changes, and loop() only cycles
+  through these digits. A 1-digit value is then lit (almost) all the
+  time, which makes short values brighter without raising the refresh
+  rate. When only one digit is lit, its symbol is not shifted out again
+  until the frame changes.
+
+  Note: the brightness of the digits now depends on the number of digits
+  that are lit, so the brightness changes with the length of the value.
+*/
+
+/*
+  NOTES ABOUT VALUE STREAMING:
+
+  When a sensor produces readings faster than a human can read them (for
+  example an ADC loop running thousands of times per second), calling
+  showFloat() for every reading wastes time on formatting, and the last
+  digit changes too fast to be readable.
+
+  Instead, enable streaming with setStreamMode() and hand every reading to
+  push(). Push only updates a few accumulators (count, sum, minimum,
+  maximum, last value). The loop() method commits the accumulated value to
+  the display at the configured update rate, so the formatting cost is only
+  paid once per visible update.
+
+  Stream policies:
+  - 'l' last value pushed.
+  - 'n' minimum of the pushed values.
+  - 'x' maximum of the pushed values.
+  - 'm' mean of the pushed values.
+
+  Hysteresis (in display units, 0 = off) suppresses a commit when the new
+  value differs less than the hysteresis from the value currently shown.
+  One display unit is one step of the last shown digit, so with 2 decimal
+  places a hysteresis of 1 means 0.01. This stops the last digit from
+  flickering between two values.
+
+  The committed value is rounded to the nearest step of the last shown
+  digit (show*() methods truncate). Values that don't fit in a long with
+  the decimal places moved to the left of the decimal point (for example
+  above 21474836.47 with 2 decimal places) show the error frame instead.
+*/
+
+/*
+  NOTES ABOUT LEVEL DISPLAY:
+
+  showLevel() shows a value as a bar graph instead of digits. The value is
+  mapped straight to segment patterns with integer arithmetic, no input
+  buffer or character conversion is involved.
+
+  Level modes (set with setLevelMode()):
+  - 'h' horizontal bar, filled from left to right. Every digit has two
+    steps (left and right vertical segments), so the resolution is
+    2 * NUM_OF_DISPLAY_DIGITS steps.
+  - 'v' vertical bar, all digits show the same fill level. The resolution
+    is 3 steps (bottom, middle and top segment).
+*/
+
+/*
+  NOTES ABOUT ANIMATIONS:
+
+  An animation is a table of AnimationFrame structs stored in flash memory
+  (PROGMEM). Every frame holds the symbols for all display digits and the
+  time (in milliseconds) the frame stays visible.
+
+  playAnimation() only stores a pointer to the table. The loop() method
+  reads the symbols of the current frame straight from flash while
+  refreshing the digits, and moves the frame pointer when the frame
+  duration has passed. No frame is ever copied to RAM.
+
+  Playback modes:
+  - 'l' loop, start again at the first frame after the last frame.
+  - 'o' one-shot, stop after the last frame.
+  - 'p' ping-pong, play forward and backward until stopped.
+
+  While an animation is playing, show*() methods still update the value in
+  the background. It becomes visible when the animation stops. An error
+  message overrides the animation. Some ready to use animations can be
+  found in Animations.h.
+*/
+
+/*
+  NOTES ABOUT THE SERIAL PROTOCOL:
+
+  A host computer can send display content as small binary frames over
+  a Stream (for example Serial). Attach the stream with attachSerial().
+  The loop() method parses the frames byte by byte, it only reads the
+  bytes that are available (at most SERIAL_MAX_BYTES_PER_LOOP per call),
+  so it never waits for data.
+
+  Frame layout:
+    SERIAL_SYNC | type | payload length | payload | checksum
+
+  The checksum is the XOR of the type, the length and all payload bytes.
+  Frames with a wrong checksum, an unknown type or a wrong payload length
+  are ignored (and counted, see getSerialFramesRejected()).
+
+  Frame types:
+  - SERIAL_TYPE_SEGMENTS: NUM_OF_DISPLAY_DIGITS raw symbol bytes (same
+    format as BinarySymbols). These are copied straight to the current
+    frame, no formatting or char conversion is involved.
+  - SERIAL_TYPE_VALUE: format ('i', 'f' or 'h'), decimal places, value as
+    4 bytes little endian (int32, float32 or uint32). Shown with showInt(),
+    showFloat() or showHex(). Ints that don't fit in an int (16 bits on
+    AVR), more decimal places than the maximum input length and floats
+    that are too large for the decimal places are rejected.
+  - SERIAL_TYPE_BRIGHTNESS: 1 byte, 0 (off) - 255 (full), see setBrightness().
+  - SERIAL_TYPE_TEXT: up to SERIAL_MAX_PAYLOAD chars, shown with showText()
+    (scrolls when longer than the display).
+*/
+
+/*
+  NOTES ABOUT BRIGHTNESS:
+
+  Brightness is set with setBrightness(), 255 = full brightness (default).
+  Below 255, a digit is switched off before its refresh interval has
+  ended: on-time = refresh interval * brightness / 255.
+
+  The on-time is measured in microseconds. loop() (or the group) reads
+  micros() once per call and passes it on, the digits don't read the
+  clock themselves.
+*/
+
+/*
+  NOTES ABOUT THE CAROUSEL:
+
+  The carousel rotates through a number of pages (for example temperature,
+  humidity and a status code), each shown for a dwell time.
+
+  A page is filled with setPageInt(), setPageFloat() or setPageHex(). The
+  value is formatted and converted to display symbols once, and stored in
+  the page (as a frame, or as a scrolling buffer when it's longer than the
+  display). Setting the same value again does nothing. Switching pages in
+  loop() only points the front frame (or the scrolling buffer) to the
+  page, there is no formatting or copying involved.
+
+  Pages are rendered in a scratch buffer, so setting a page doesn't
+  change a value that is shown (or scrolling) with a show*() method.
+  While the carousel runs, use the setPage*() methods instead of the
+  show*() methods.
+
+  The number of pages is set in NUM_OF_CAROUSEL_PAGES, every page uses
+  about BUFFER_LENGTH + 14 bytes of RAM.
+*/
+
+struct CarouselPage {
+  byte buffer[BUFFER_LENGTH]; // frame or scrolling buffer.
+  int numOfScrollingFrames; // 0 = frame, no scrolling.
+  unsigned int dwell; // milliseconds.
+
+  // rendered value, used to skip rendering when the value is unchanged.
+  char type; // i int, f float, h hex, ' ' empty.
+  long valueLong;
+  float valueFloat;
+  int decimalPlaces;
+};
+
+struct AnimationFrame {
+  byte symbols[NUM_OF_DISPLAY_DIGITS];
+  unsigned int duration; // milliseconds.
+};
+
 
 class Seg4DigitHC164 {
   
+  // the group scheduler calls refreshDigit() and updateState() directly.
+  friend class Seg4DigitGroup;
+
   private:
 
     // shift register pins, led segment digit pins.
@@ -119,11 +314,14 @@ class Seg4DigitHC164 {
 
     // output data.
     byte currentFrame[NUM_OF_DISPLAY_DIGITS];
-    byte currentFrameCopy[NUM_OF_DISPLAY_DIGITS];
+    byte errorFrame[NUM_OF_DISPLAY_DIGITS];
+    byte* frontFrame; // frame shown on the display.
+    bool frameChanged; // set when the shown symbols may have changed.
 
     // scrolling data.
     bool scrolling;
     int numOfscrollingFrames;
+    byte* scrollingBuffer; // display buffer or carousel page.
     int scrollingInterval;
     int currentScrollingFrame;
     unsigned long timeStampFrame; 
@@ -140,14 +338,90 @@ class Seg4DigitHC164 {
     int refreshRate;
     unsigned int refreshRateMillis;
 
+    // blank digit skipping data.
+    bool skipBlankDigits;
+    byte activeDigits[NUM_OF_DISPLAY_DIGITS];
+    byte numOfActiveDigits;
+    byte currentActiveDigit;
+
+    // value streaming data.
+    bool streaming;
+    char streamPolicy;
+    int streamDecimalPlaces;
+    float streamHysteresis;
+    unsigned int streamIntervalMillis;
+    unsigned long timeStampStream;
+    unsigned int streamCount;
+    float streamSum;
+    float streamMin;
+    float streamMax;
+    float streamLast;
+    float streamShownValue;
+    bool streamValueShown;
+
+    // level display data.
+    char levelMode;
+
+    // animation data.
+    bool animating;
+    char animationMode;
+    const AnimationFrame* animationFrames; // table in flash memory.
+    const AnimationFrame* animationFrame; // frame shown, points into the table.
+    int numOfAnimationFrames;
+    int currentAnimationFrame;
+    int animationDirection;
+    unsigned int animationFrameDuration;
+    unsigned long timeStampAnimation;
+
+    // brightness data.
+    byte brightness;
+    unsigned long digitOnTimeMicros;
+    unsigned long timeStampDigitOn;
+    bool digitOn;
+
+    // serial protocol data.
+    Stream* serialStream;
+    char serialState;
+    byte serialType;
+    byte serialLength;
+    byte serialIndex;
+    byte serialChecksum;
+    byte serialPayload[SERIAL_MAX_PAYLOAD + 1]; // back frame, + 1 for text null terminator.
+    unsigned long serialFramesAccepted;
+    unsigned long serialFramesRejected;
+
+    // carousel data.
+    CarouselPage carouselPages[NUM_OF_CAROUSEL_PAGES];
+    bool carouselRunning;
+    int numOfCarouselPages;
+    int currentPage;
+    unsigned long timeStampPage;
+
     // methods.
     void buildInputBuffer(char outputType, int decimalPlaces = 0);
-    void buildDisplayBuffer(int pointIndex = -1);
+    void buildDisplayBuffer(byte* buffer, int pointIndex = -1);
     void processDisplayBuffer();
-    void updateCurrentFrame();
+    void buildFrame(byte* frame, const byte* source);
+
+    int buildScrollingBuffer(byte* buffer, const byte* source);
+    void updateScrollingFrame(unsigned long now);
+
+    void refreshDigit(unsigned long now, unsigned long nowMicros);
+    byte getSymbol(byte digit);
+    void buildActiveDigits();
+    void updateState(unsigned long now, unsigned long nowMicros);
+
+    void updateStream(unsigned long now);
+    void updateAnimation(unsigned long now);
+    void updateBrightness(unsigned long nowMicros);
+
+    void processSerial();
+    bool processSerialFrame();
 
-    void buildScrollingBuffer();
-    void updateScrollingFrame();
+    void updateCarousel(unsigned long now);
+    void showPage(int page);
+    void renderPage(int page);
+    bool isValidPage(int page);
 
     void removeError();
     long convertFloatToLong(int decimalPlaces);
@@ -163,6 +437,36 @@ class Seg4DigitHC164 {
     void showFloat(float input, int decimalPlaces);
     void showHex(unsigned long input);
     void showError();
+    void showText(const char* input);
+    void setBrightness(byte level);
+    void setBlankSkipping(bool skip);
+
+    // value streaming.
+    void setStreamMode(char policy, int updateRate, int decimalPlaces = 0, float hysteresis = 0);
+    void stopStream();
+    void push(float input);
+
+    // level display.
+    void setLevelMode(char mode);
+    void showLevel(int value, int max);
+
+    // animations.
+    void playAnimation(const AnimationFrame* frames, int numOfFrames, char mode);
+    void stopAnimation();
+    bool isAnimating();
+
+    // serial protocol.
+    void attachSerial(Stream* stream);
+    unsigned long getSerialFramesAccepted();
+    unsigned long getSerialFramesRejected();
+
+    // carousel.
+    void setPageInt(int page, int input);
+    void setPageFloat(int page, float input, int decimalPlaces);
+    void setPageHex(int page, unsigned long input);
+    void setPageDwell(int page, unsigned int dwellMillis);
+    void startCarousel(int numOfPages, unsigned int dwellMillis);
+    void stopCarousel();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,585 @@
+#ifndef ARDUINO
+
+#include <stdio.h>
+#include "../include/VirtualMCU.h"
+
+// the virtual microcontroller used by the Arduino API functions below.
+VirtualMCU virtualMCU;
+HostSerial Serial;
+
+/*
+  -----------------
+  ARDUINO API
+  -----------------
+*/
+
+void pinMode(byte pin, byte mode)
+{
+  virtualMCU.pinMode(pin, mode);
+}
+
+void digitalWrite(byte pin, byte value)
+{
+  virtualMCU.digitalWrite(pin, value);
+}
+
+void shiftOut(byte dataPin, byte clockPin, byte bitOrder, byte value)
+// same bit banging sequence as the Arduino core, so every bit shows up in the trace.
+{
+  for (int i = 0; i < 8; i++)
+  {
+    if (bitOrder == LSBFIRST)
+    {
+      digitalWrite(dataPin, (value >> i) & 1);
+    }
+    else
+    {
+      digitalWrite(dataPin, (value >> (7 - i)) & 1);
+    }
+
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+unsigned long millis()
+{
+  return virtualMCU.getMicros() / 1000;
+}
+
+unsigned long micros()
+{
+  return virtualMCU.getMicros();
+}
+
+
+
+/*
+  -----------------
+  CONSTRUCTOR
+  -----------------
+*/
+
+VirtualMCU::VirtualMCU()
+{
+  reset();
+}
+
+
+
+/*
+  -----------------
+  PUBLIC METHODS
+  -----------------
+*/
+
+void VirtualMCU::reset()
+// set time to zero, all pins low and unnamed, remove the trace.
+{
+  currentMicros = 0;
+  digitalWriteCost = 4;
+
+  for (int i = 0; i < NUM_OF_VIRTUAL_PINS; i++)
+  {
+    pinStates[i] = LOW;
+    pinUsed[i] = false;
+    pinNames[i] = NULL;
+    traceStartStates[i] = LOW;
+  }
+
+  tracing = false;
+  traceStart = 0;
+  trace.clear();
+
+  litThreshold = 50;
+  numOfDisplayDigits = 0;
+  displayCommonAnode = true;
+  displayRegister = 0xFF;
+  traceStartRegister = 0xFF;
+}
+
+unsigned long VirtualMCU::getMicros()
+{
+  return currentMicros;
+}
+
+void VirtualMCU::advance(unsigned long duration)
+// let time pass without pin activity.
+{
+  currentMicros += duration;
+}
+
+void VirtualMCU::runFor(unsigned long duration, void (*loopFunction)(), unsigned int loopCost)
+/*
+  Call loopFunction repeatedly until duration (microseconds) has passed.
+  loopCost is the time one call takes besides its pin writes, so time
+  keeps moving when loopFunction has nothing to do.
+*/
+{
+  unsigned long end = currentMicros + duration;
+
+  while (currentMicros < end)
+  {
+    loopFunction();
+    currentMicros += loopCost;
+  }
+}
+
+void VirtualMCU::setPinName(byte pin, const char* name)
+// name shown in the VCD file, default is 'pin' + pin number.
+{
+  if (pin < NUM_OF_VIRTUAL_PINS)
+  {
+    pinNames[pin] = name;
+  }
+}
+
+void VirtualMCU::pinMode(byte pin, byte mode)
+{
+  if (pin < NUM_OF_VIRTUAL_PINS && mode == OUTPUT)
+  {
+    pinUsed[pin] = true;
+  }
+}
+
+void VirtualMCU::digitalWrite(byte pin, byte value)
+// set pin state, store event in the trace (if tracing) and spend digitalWriteCost.
+{
+  if (pin >= NUM_OF_VIRTUAL_PINS)
+  {
+    return;
+  }
+
+  value = value ? HIGH : LOW;
+
+  if (numOfDisplayDigits > 0 && pin == displayClockPin && value == HIGH && pinStates[pin] == LOW)
+  {
+    // rising clock edge: keep track of the display shift register.
+    displayRegister = (displayRegister >> 1) | (pinStates[displayDataPin] << 7);
+  }
+
+  pinStates[pin] = value;
+  pinUsed[pin] = true;
+
+  if (tracing)
+  {
+    PinEvent event;
+    event.time = currentMicros;
+    event.pin = pin;
+    event.value = value;
+    trace.push_back(event);
+  }
+
+  currentMicros += digitalWriteCost;
+}
+
+byte VirtualMCU::getPinState(byte pin)
+{
+  if (pin >= NUM_OF_VIRTUAL_PINS)
+  {
+    return LOW;
+  }
+
+  return pinStates[pin];
+}
+
+void VirtualMCU::startTrace()
+// start a new trace, remembers the current pin states as the starting point.
+{
+  clearTrace();
+
+  for (int i = 0; i < NUM_OF_VIRTUAL_PINS; i++)
+  {
+    traceStartStates[i] = pinStates[i];
+  }
+
+  traceStart = currentMicros;
+  traceStartRegister = displayRegister;
+  tracing = true;
+}
+
+void VirtualMCU::stopTrace()
+{
+  tracing = false;
+}
+
+void VirtualMCU::clearTrace()
+{
+  trace.clear();
+}
+
+int VirtualMCU::getTraceLength()
+{
+  return trace.size();
+}
+
+PinEvent VirtualMCU::getTraceEvent(int index)
+{
+  return trace[index];
+}
+
+unsigned long VirtualMCU::getHighTime(byte pin, unsigned long from, unsigned long to)
+/*
+  Calculate how long (microseconds) pin was high between from and to,
+  using the trace. Useful for measuring the on-time of a digit pin.
+*/
+{
+  if (pin >= NUM_OF_VIRTUAL_PINS || to <= from)
+  {
+    return 0;
+  }
+
+  unsigned long highTime = 0;
+  unsigned long changeTime = traceStart;
+  byte state = traceStartStates[pin];
+
+  for (size_t i = 0; i < trace.size(); i++)
+  {
+    if (trace[i].pin != pin || trace[i].value == state)
+    {
+      continue;
+    }
+
+    if (state == HIGH && trace[i].time > from)
+    {
+      // add the part of this high period that lies inside the window.
+      unsigned long start = changeTime > from ? changeTime : from;
+      unsigned long end = trace[i].time < to ? trace[i].time : to;
+      if (end > start) highTime += end - start;
+    }
+
+    state = trace[i].value;
+    changeTime = trace[i].time;
+
+    if (changeTime >= to)
+    {
+      return highTime;
+    }
+  }
+
+  if (state == HIGH)
+  {
+    // pin is still high at the end of the trace.
+    unsigned long start = changeTime > from ? changeTime : from;
+    if (to > start) highTime += to - start;
+  }
+
+  return highTime;
+}
+
+bool VirtualMCU::writeVCD(const char* fileName)
+/*
+  Write the trace to a Value Change Dump file (timescale 1 us).
+  Only pins that are used are written. Returns false when the file
+  cannot be opened.
+*/
+{
+  FILE* file = fopen(fileName, "w");
+
+  if (file == NULL)
+  {
+    return false;
+  }
+
+  int i = 0;
+  byte lastValues[NUM_OF_VIRTUAL_PINS];
+
+  fprintf(file, "$timescale 1us $end\n");
+  fprintf(file, "$scope module seg4digithc164 $end\n");
+
+  for (i = 0; i < NUM_OF_VIRTUAL_PINS; i++)
+  {
+    if (!pinUsed[i]) continue;
+
+    // identifier code: one printable char per pin, starting at '!'.
+    if (pinNames[i] != NULL)
+    {
+      fprintf(file, "$var wire 1 %c %s $end\n", '!' + i, pinNames[i]);
+    }
+    else
+    {
+      fprintf(file, "$var wire 1 %c pin%d $end\n", '!' + i, i);
+    }
+  }
+
+  fprintf(file, "$upscope $end\n");
+  fprintf(file, "$enddefinitions $end\n");
+
+  // initial values.
+  fprintf(file, "#%lu\n$dumpvars\n", traceStart);
+
+  for (i = 0; i < NUM_OF_VIRTUAL_PINS; i++)
+  {
+    lastValues[i] = traceStartStates[i];
+    if (pinUsed[i]) fprintf(file, "%d%c\n", lastValues[i], '!' + i);
+  }
+
+  fprintf(file, "$end\n");
+
+  // value changes, writes that don't change the pin state are skipped.
+  unsigned long lastTime = traceStart;
+
+  for (size_t e = 0; e < trace.size(); e++)
+  {
+    const PinEvent& event = trace[e];
+
+    if (event.value == lastValues[event.pin]) continue;
+
+    if (event.time != lastTime)
+    {
+      fprintf(file, "#%lu\n", event.time);
+      lastTime = event.time;
+    }
+
+    fprintf(file, "%d%c\n", event.value, '!' + event.pin);
+    lastValues[event.pin] = event.value;
+  }
+
+  fprintf(file, "#%lu\n", currentMicros);
+  fclose(file);
+
+  return true;
+}
+
+void VirtualMCU::attachDisplay(byte dataPin, byte clockPin, const byte* digitPins, int numOfDigits, bool commonAnode)
+// tell the VirtualMCU how the display is connected, needed for reconstructFrame().
+{
+  if (numOfDigits > NUM_OF_PERCEIVED_DIGITS)
+  {
+    numOfDigits = NUM_OF_PERCEIVED_DIGITS;
+  }
+
+  displayDataPin = dataPin;
+  displayClockPin = clockPin;
+  numOfDisplayDigits = numOfDigits;
+  displayCommonAnode = commonAnode;
+  displayRegister = commonAnode ? 0xFF : 0x00; // assume all leds off.
+  traceStartRegister = displayRegister;
+
+  for (int i = 0; i < numOfDigits; i++)
+  {
+    displayDigitPins[i] = digitPins[i];
+  }
+}
+
+unsigned long VirtualMCU::getCycleStart(int cycle)
+/*
+  Returns the time at which multiplex cycle number 'cycle' (zero indexed)
+  starts: a rising edge of the first display digit that is switched on
+  in the trace (digits that are never switched on are skipped). Returns
+  the current time when the trace has no such cycle.
+
+  When no digit is switched on in the trace, the display is static (a
+  single lit digit is not refreshed when blank digits are skipped, and a
+  blank display is not refreshed at all) and the whole trace is one
+  cycle: cycle 0 starts at the start of the trace, cycle 1 at the
+  current time.
+*/
+{
+  for (int d = 0; d < numOfDisplayDigits; d++)
+  {
+    byte pin = displayDigitPins[d];
+    byte state = traceStartStates[pin];
+    int cycleCount = 0;
+
+    for (size_t i = 0; i < trace.size(); i++)
+    {
+      if (trace[i].pin != pin) continue;
+
+      if (trace[i].value == HIGH && state == LOW)
+      {
+        if (cycleCount == cycle) return trace[i].time;
+        cycleCount++;
+      }
+
+      state = trace[i].value;
+    }
+
+    if (cycleCount > 0)
+    {
+      // this digit is used, but the trace has too few cycles.
+      return currentMicros;
+    }
+  }
+
+  // static display, the whole trace is one cycle.
+  return cycle == 0 ? traceStart : currentMicros;
+}
+
+bool VirtualMCU::reconstructFrame(unsigned long from, unsigned long to, PerceivedFrame& frame)
+/*
+  Replay the trace and calculate the perceived frame between from and to.
+
+  Shift register model: on every rising clock edge the SN74HC164 shifts
+  the data pin into its first output. The library shifts LSB first, so
+  after 8 clock pulses the register holds the symbol byte. The register
+  is tracked in the same bit numbering as the symbol bytes, which makes
+  every partially shifted state visible as a (ghost) symbol too.
+
+  Returns false when no display is attached or the window is empty.
+*/
+{
+  int d = 0;
+  int b = 0;
+
+  if (numOfDisplayDigits == 0 || to <= from)
+  {
+    return false;
+  }
+
+  memset(&frame, 0, sizeof(frame));
+  frame.start = from;
+  frame.end = to;
+
+  byte pins[NUM_OF_VIRTUAL_PINS];
+  memcpy(pins, traceStartStates, sizeof(pins));
+
+  byte shiftRegister = traceStartRegister;
+  unsigned long time = traceStart;
+
+  for (size_t i = 0; i <= trace.size(); i++)
+  {
+    // end of the period in which the current state is visible.
+    unsigned long eventTime = (i < trace.size()) ? trace[i].time : currentMicros;
+
+    if (eventTime > to) eventTime = to;
+
+    if (eventTime > from && eventTime > time)
+    {
+      unsigned long start = time > from ? time : from;
+      unsigned long duration = eventTime - start;
+
+      for (d = 0; d < numOfDisplayDigits; d++)
+      {
+        if (pins[displayDigitPins[d]] != HIGH) continue;
+
+        frame.digitOnTime[d] += duration;
+
+        for (b = 0; b < 8; b++)
+        {
+          bool bitSet = (shiftRegister >> b) & 1;
+
+          if (bitSet != displayCommonAnode) // common anode: 0 = led on.
+          {
+            frame.segmentOnTime[d][b] += duration;
+          }
+        }
+      }
+    }
+
+    if (i == trace.size() || trace[i].time >= to)
+    {
+      break;
+    }
+
+    const PinEvent& event = trace[i];
+
+    if (event.pin == displayClockPin && event.value == HIGH && pins[displayClockPin] == LOW)
+    {
+      // rising clock edge: shift data pin into the register.
+      shiftRegister = (shiftRegister >> 1) | (pins[displayDataPin] << 7);
+    }
+
+    pins[event.pin] = event.value;
+    time = event.time;
+  }
+
+  // build perceived symbols.
+  for (d = 0; d < numOfDisplayDigits; d++)
+  {
+    byte symbol = 0;
+
+    for (b = 0; b < 8; b++)
+    {
+      bool lit = frame.digitOnTime[d] > 0 &&
+        frame.segmentOnTime[d][b] * 100 >= frame.digitOnTime[d] * litThreshold;
+
+      if (lit != displayCommonAnode)
+      {
+        symbol |= (1 << b);
+      }
+    }
+
+    frame.symbols[d] = symbol;
+  }
+
+  return true;
+}
+
+bool VirtualMCU::frameMatches(const PerceivedFrame& frame, const byte* expectedSymbols)
+// compare the perceived symbols with the expected symbols of all attached digits.
+{
+  for (int d = 0; d < numOfDisplayDigits; d++)
+  {
+    if (frame.symbols[d] != expectedSymbols[d])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+
+/*
+  -----------------
+  VIRTUAL STREAM
+  -----------------
+*/
+
+VirtualStream::VirtualStream()
+{
+  readIndex = 0;
+  readCost = 1;
+}
+
+void VirtualStream::write(byte input)
+// add a byte to the stream, as if it was received.
+{
+  if (readIndex == buffer.size())
+  {
+    // everything has been read, start with an empty buffer.
+    buffer.clear();
+    readIndex = 0;
+  }
+
+  buffer.push_back(input);
+}
+
+void VirtualStream::write(const byte* input, int length)
+{
+  for (int i = 0; i < length; i++)
+  {
+    write(input[i]);
+  }
+}
+
+int VirtualStream::available()
+{
+  return buffer.size() - readIndex;
+}
+
+int VirtualStream::read()
+// returns -1 when no data is available, like Arduino streams.
+{
+  if (readIndex == buffer.size())
+  {
+    return -1;
+  }
+
+  virtualMCU.advance(readCost);
+  return buffer[readIndex++];
+}
+
+int VirtualStream::peek()
+{
+  if (readIndex == buffer.size())
+  {
+    return -1;
+  }
+
+  return buffer[readIndex];
+}
+
+#endif
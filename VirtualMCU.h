@@ -0,0 +1,236 @@
+/*
+  VirtualMCU.h - Virtual microcontroller for running the Seg4DigitHC164
+  library on a host computer (Linux, no Arduino board needed).
+
+  When the library is compiled without the Arduino environment (the
+  ARDUINO macro is not defined), the library includes this file instead
+  of Arduino.h. It provides the small part of the Arduino API the library
+  uses: pinMode(), digitalWrite(), shiftOut(), millis(), micros(), Serial
+  and the PROGMEM helpers.
+
+  Virtual time:
+  Time only moves when the program tells it to. Every digitalWrite()
+  costs digitalWriteCost microseconds (default 4, about the time an
+  Arduino Uno needs), so a shiftOut() of one byte (24 writes) takes about
+  100 microseconds. Use advance() or runFor() to let time pass between
+  loop() calls.
+
+  Pin trace:
+  While tracing is active, every digitalWrite() is stored as a PinEvent
+  with a timestamp, including every data and clock bit of shiftOut().
+  Note: the SN74HC164 has no latch, the outputs change on every clock
+  edge. The digit pins act as the 'latch': the events of the digit pins
+  show when a symbol becomes visible.
+
+  The trace can be read with getTraceLength() and getTraceEvent(), or
+  written to a VCD file with writeVCD(). VCD files can be opened with
+  GTKWave.
+
+  Perceived frames:
+  After attachDisplay() has told the VirtualMCU how the display is
+  connected, reconstructFrame() replays the trace through a model of the
+  SN74HC164 and the digit pins, and calculates what a human would see
+  in a time window: for every digit how long it was on, and for every
+  segment how long it was lit. A segment is perceived as lit when it was
+  lit for at least litThreshold percent of the digit on-time, so short
+  ghosting while the shift register is being filled is ignored.
+  The perceived symbols use the same bit layout and polarity as the
+  bytes in BinarySymbols, so they can be compared with expected
+  (golden) symbols directly with frameMatches().
+
+  getCycleStart() returns the start of a multiplex cycle (the moment the
+  first digit switches on), to reconstruct one frame per cycle. When no
+  digit switches on during the trace (a static display), the whole trace
+  counts as one cycle.
+
+  Attach the display before starting the trace: the VirtualMCU then
+  keeps track of the shift register contents, so a symbol that was
+  shifted out before the trace started (for example a single lit digit
+  that is not refreshed) is reconstructed correctly.
+
+  Virtual stream:
+  VirtualStream is a Stream filled by the program with write(), for
+  feeding serial protocol frames to Seg4DigitHC164::attachSerial(). Every
+  read() costs readCost microseconds. To measure how many updates per
+  second the serial path sustains, write a number of frames, call loop()
+  until available() returns 0, and divide getSerialFramesAccepted() by
+  the virtual time that has passed (see test/serial_rate_test.cpp).
+
+  Example (host build):
+    g++ -I<path> Seg4DigitHC164.cpp BinarySymbols.cpp VirtualMCU.cpp sim.cpp
+
+    // sim.cpp
+    Seg4DigitHC164 display;
+    void displayLoop() { display.loop(); }
+
+    int main() {
+      byte digitPins[] = {8, 9, 10, 11};
+      display.init(2, 3, digitPins);
+      display.showInt(42);
+      virtualMCU.startTrace();
+      virtualMCU.runFor(100000, displayLoop); // 100 ms.
+      virtualMCU.writeVCD("display.vcd");
+    }
+
+  For study purposes.
+*/
+
+#ifndef VIRTUALMCU_H
+#define VIRTUALMCU_H
+
+#ifndef ARDUINO
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define NUM_OF_VIRTUAL_PINS 64
+#define NUM_OF_PERCEIVED_DIGITS 8
+
+/*
+  -----------------
+  ARDUINO API
+  -----------------
+*/
+
+typedef uint8_t byte;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define PROGMEM
+#define F(input) (input)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+
+void pinMode(byte pin, byte mode);
+void digitalWrite(byte pin, byte value);
+void shiftOut(byte dataPin, byte clockPin, byte bitOrder, byte value);
+unsigned long millis();
+unsigned long micros();
+
+class HostSerial {
+  // serial output is discarded, it would only slow down the simulation.
+  public:
+    void begin(unsigned long) {}
+    template <typename T> void print(T) {}
+    template <typename T> void println(T) {}
+    void println() {}
+};
+
+extern HostSerial Serial;
+
+class Stream {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/*
+  -----------------
+  VIRTUAL MCU
+  -----------------
+*/
+
+struct PinEvent {
+  unsigned long time; // microseconds.
+  byte pin;
+  byte value;
+};
+
+struct PerceivedFrame {
+  unsigned long start; // microseconds.
+  unsigned long end;
+  unsigned long digitOnTime[NUM_OF_PERCEIVED_DIGITS];
+  unsigned long segmentOnTime[NUM_OF_PERCEIVED_DIGITS][8]; // index = bit number.
+  byte symbols[NUM_OF_PERCEIVED_DIGITS];
+};
+
+class VirtualMCU {
+  private:
+    unsigned long currentMicros;
+    byte pinStates[NUM_OF_VIRTUAL_PINS];
+    bool pinUsed[NUM_OF_VIRTUAL_PINS];
+    const char* pinNames[NUM_OF_VIRTUAL_PINS];
+
+    bool tracing;
+    unsigned long traceStart;
+    byte traceStartStates[NUM_OF_VIRTUAL_PINS];
+    std::vector<PinEvent> trace;
+
+    // display connection, used for frame reconstruction.
+    byte displayDataPin;
+    byte displayClockPin;
+    byte displayDigitPins[NUM_OF_PERCEIVED_DIGITS];
+    int numOfDisplayDigits;
+    bool displayCommonAnode;
+    byte displayRegister; // shift register contents, updated on every clock pulse.
+    byte traceStartRegister;
+
+  public:
+    VirtualMCU();
+    void reset();
+
+    // cost of one digitalWrite() in microseconds.
+    unsigned int digitalWriteCost;
+
+    // virtual time.
+    unsigned long getMicros();
+    void advance(unsigned long duration);
+    void runFor(unsigned long duration, void (*loopFunction)(), unsigned int loopCost = 10);
+
+    // pins.
+    void setPinName(byte pin, const char* name);
+    void pinMode(byte pin, byte mode);
+    void digitalWrite(byte pin, byte value);
+    byte getPinState(byte pin);
+
+    // trace.
+    void startTrace();
+    void stopTrace();
+    void clearTrace();
+    int getTraceLength();
+    PinEvent getTraceEvent(int index);
+    unsigned long getHighTime(byte pin, unsigned long from, unsigned long to);
+    bool writeVCD(const char* fileName);
+
+    // perceived frames.
+    int litThreshold; // percent of digit on-time, default 50.
+    void attachDisplay(byte dataPin, byte clockPin, const byte* digitPins, int numOfDigits, bool commonAnode = true);
+    unsigned long getCycleStart(int cycle);
+    bool reconstructFrame(unsigned long from, unsigned long to, PerceivedFrame& frame);
+    bool frameMatches(const PerceivedFrame& frame, const byte* expectedSymbols);
+};
+
+extern VirtualMCU virtualMCU;
+
+class VirtualStream : public Stream {
+  private:
+    std::vector<byte> buffer;
+    size_t readIndex;
+
+  public:
+    VirtualStream();
+
+    // cost of one read() in microseconds.
+    unsigned int readCost;
+
+    void write(byte input);
+    void write(const byte* input, int length);
+    int available();
+    int read();
+    int peek();
+};
+
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# build.sh - Build and run the host tests of the Seg4DigitHC164 library.
+#
+# The library is compiled with g++ against VirtualMCU (no Arduino needed),
+# every test/*_test.cpp is linked with it and executed. The script stops
+# with a non-zero exit code when a test fails.
+#
+# Usage (from any directory): sh test/build.sh
+#
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD="$ROOT/_host_build"
+CXXFLAGS="-std=gnu++11 -O1 -Wall"
+
+# the sources include "../include/<file>.h", provide that layout.
+mkdir -p "$BUILD/src"
+ln -sfn "$ROOT" "$BUILD/include"
+
+OBJECTS=""
+for SOURCE in "$ROOT"/*.cpp; do
+  NAME=$(basename "$SOURCE" .cpp)
+  [ "$NAME" = "main" ] && continue # Arduino sketch.
+  g++ $CXXFLAGS -I"$BUILD/src" -c "$SOURCE" -o "$BUILD/$NAME.o"
+  OBJECTS="$OBJECTS $BUILD/$NAME.o"
+done
+
+for TEST in "$ROOT"/test/*_test.cpp; do
+  NAME=$(basename "$TEST" .cpp)
+  g++ $CXXFLAGS -I"$BUILD/src" "$TEST" $OBJECTS -o "$BUILD/$NAME"
+  echo "running $NAME"
+  "$BUILD/$NAME"
+done
+
+echo "all tests passed"
@@ -0,0 +1,154 @@
+/*
+  duty_cycle_test.cpp - Digit on-time with blank digit skipping.
+
+  With setBlankSkipping(true) only the digits that are not blank are
+  multiplexed, so every lit digit is on for 1 / (number of lit digits)
+  of the time: 100% for a single digit, 50% for two digits and 25% for
+  four digits. The on-time per digit is measured from the pin trace with
+  VirtualMCU::reconstructFrame().
+  A single lit digit is shifted out once and then left on, so in steady
+  state there are no pin writes at all.
+
+  Build and run with test/build.sh.
+*/
+
+#include <stdio.h>
+#include "../include/Seg4DigitHC164.h"
+
+#define MEASURE_MICROS 1000000 // 1 second.
+#define TOLERANCE_PERCENT 2
+
+byte dataPin = 2;
+byte clockPin = 3;
+byte digitPins[] = {8, 9, 10, 11};
+
+Seg4DigitHC164 display;
+int failures = 0;
+
+void displayLoop()
+{
+  display.loop();
+}
+
+void setUp()
+// fresh virtual MCU and display with blank digit skipping, time starts at 1 second.
+{
+  virtualMCU.reset();
+  virtualMCU.attachDisplay(dataPin, clockPin, digitPins, NUM_OF_DISPLAY_DIGITS);
+  display.init(dataPin, clockPin, digitPins);
+  display.setBlankSkipping(true);
+  virtualMCU.runFor(1000000, displayLoop);
+}
+
+void measure(PerceivedFrame& frame)
+// let the new value settle, then trace MEASURE_MICROS and reconstruct the on-times.
+{
+  virtualMCU.runFor(100000, displayLoop);
+
+  unsigned long start = virtualMCU.getMicros();
+
+  virtualMCU.startTrace();
+  virtualMCU.runFor(MEASURE_MICROS, displayLoop);
+  virtualMCU.stopTrace();
+  virtualMCU.reconstructFrame(start, start + MEASURE_MICROS, frame);
+}
+
+void expectDuty(const char* name, const PerceivedFrame& frame, const int* expectedPercent)
+// compare the on-time of every digit (percent of the measured time) with the expected duty cycle.
+{
+  for (int i = 0; i < NUM_OF_DISPLAY_DIGITS; i++)
+  {
+    int percent = (int)((frame.digitOnTime[i] * 100 + MEASURE_MICROS / 2) / MEASURE_MICROS);
+
+    if (abs(percent - expectedPercent[i]) <= TOLERANCE_PERCENT)
+    {
+      printf("  ok    %s digit %d: %d%%\n", name, i, percent);
+    }
+    else
+    {
+      printf("  FAIL  %s digit %d: expected %d%%, seen %d%%\n", name, i, expectedPercent[i], percent);
+      failures++;
+    }
+  }
+}
+
+void testDutyCycle()
+{
+  PerceivedFrame frame;
+
+  printf("duty cycle\n");
+  setUp();
+
+  display.showInt(7);
+  measure(frame);
+  const int oneDigit[] = {0, 0, 0, 100};
+  expectDuty("1 digit", frame, oneDigit);
+
+  display.showInt(42);
+  measure(frame);
+  const int twoDigits[] = {0, 0, 50, 50};
+  expectDuty("2 digits", frame, twoDigits);
+
+  display.showInt(1234);
+  measure(frame);
+  const int fourDigits[] = {25, 25, 25, 25};
+  expectDuty("4 digits", frame, fourDigits);
+}
+
+void testStoppedCarousel()
+// a page that stays on the display after stopCarousel() is re-rendered: all its digits must be refreshed.
+{
+  PerceivedFrame frame;
+
+  printf("stopped carousel\n");
+  setUp();
+
+  display.setPageInt(0, 7);
+  display.startCarousel(1, 1000);
+  virtualMCU.runFor(100000, displayLoop);
+  display.stopCarousel();
+
+  display.setPageInt(0, 1234);
+  measure(frame);
+  const int fourDigits[] = {25, 25, 25, 25};
+  expectDuty("page 7 -> 1234", frame, fourDigits);
+}
+
+void testSteadyState()
+{
+  printf("steady state\n");
+  setUp();
+
+  display.showInt(7);
+  virtualMCU.runFor(100000, displayLoop);
+
+  virtualMCU.startTrace();
+  virtualMCU.runFor(MEASURE_MICROS, displayLoop);
+  virtualMCU.stopTrace();
+
+  if (virtualMCU.getTraceLength() == 0)
+  {
+    printf("  ok    1 digit: no pin writes\n");
+  }
+  else
+  {
+    printf("  FAIL  1 digit: expected no pin writes, seen %d\n", virtualMCU.getTraceLength());
+    failures++;
+  }
+}
+
+int main()
+{
+  testDutyCycle();
+  testStoppedCarousel();
+  testSteadyState();
+
+  if (failures > 0)
+  {
+    printf("%d duty cycle test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("duty cycle tests passed\n");
+  return 0;
+}
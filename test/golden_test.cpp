@@ -0,0 +1,320 @@
+/*
+  golden_test.cpp - Golden output tests for the Seg4DigitHC164 library.
+
+  Runs the library on the VirtualMCU, reconstructs the frame a human
+  would see from the pin trace (see VirtualMCU::reconstructFrame()) and
+  compares it with the expected (golden) symbols. This proves that
+  changes to the refresh engine don't change what is shown. Every case
+  runs twice: refreshing all digits, and with blank digit skipping.
+
+  Build and run with test/build.sh.
+*/
+
+#include <stdio.h>
+#include "../include/Seg4DigitHC164.h"
+#include "../include/BinarySymbols.h"
+
+#define B BinarySymbols::blank
+
+byte dataPin = 2;
+byte clockPin = 3;
+byte digitPins[] = {8, 9, 10, 11};
+
+Seg4DigitHC164 display;
+BinarySymbols symbols;
+bool blankSkipping = false;
+int failures = 0;
+
+void displayLoop()
+{
+  display.loop();
+}
+
+void setUp()
+// fresh virtual MCU and display, time starts at 1 second.
+{
+  virtualMCU.reset();
+  virtualMCU.attachDisplay(dataPin, clockPin, digitPins, NUM_OF_DISPLAY_DIGITS);
+  display.init(dataPin, clockPin, digitPins);
+  display.setBlankSkipping(blankSkipping);
+  virtualMCU.runFor(1000000, displayLoop);
+}
+
+void runUntil(unsigned long millisTime)
+{
+  if (virtualMCU.getMicros() < millisTime * 1000)
+  {
+    virtualMCU.runFor(millisTime * 1000 - virtualMCU.getMicros(), displayLoop);
+  }
+}
+
+void expectFrame(const char* name, byte d0, byte d1, byte d2, byte d3)
+// trace two multiplex cycles and compare the perceived frame of the first full cycle.
+{
+  PerceivedFrame frame;
+  byte expected[NUM_OF_DISPLAY_DIGITS] = {d0, d1, d2, d3};
+
+  virtualMCU.startTrace();
+  virtualMCU.runFor(40000, displayLoop);
+  virtualMCU.stopTrace();
+
+  if (!virtualMCU.reconstructFrame(virtualMCU.getCycleStart(0), virtualMCU.getCycleStart(1), frame))
+  {
+    printf("  FAIL  %s: no multiplex cycle in the trace\n", name);
+    failures++;
+  }
+  else if (virtualMCU.frameMatches(frame, expected))
+  {
+    printf("  ok    %s\n", name);
+  }
+  else
+  {
+    printf("  FAIL  %s: expected %02x %02x %02x %02x, seen %02x %02x %02x %02x\n", name,
+      expected[0], expected[1], expected[2], expected[3],
+      frame.symbols[0], frame.symbols[1], frame.symbols[2], frame.symbols[3]);
+    failures++;
+  }
+}
+
+void expectScrolling(const char* name, const byte* expected, int numOfFrames)
+/*
+  Check every frame of a scrolling animation. The show*() call must be
+  made right before: scrolling then starts immediately and the frame
+  changes every 300 ms, the frame is checked 100 ms after it appears.
+*/
+{
+  unsigned long start = virtualMCU.getMicros() / 1000;
+  char frameName[64];
+
+  for (int i = 0; i < numOfFrames; i++)
+  {
+    runUntil(start + 300 * i + 100);
+    snprintf(frameName, sizeof(frameName), "%s frame %d", name, i);
+    expectFrame(frameName, expected[i * 4], expected[i * 4 + 1], expected[i * 4 + 2], expected[i * 4 + 3]);
+  }
+}
+
+void testShowInt()
+{
+  printf("showInt\n");
+  setUp();
+
+  display.showInt(1234);
+  expectFrame("1234", symbols.one, symbols.two, symbols.three, symbols.four);
+
+  display.showInt(0);
+  expectFrame("0", B, B, B, symbols.zero);
+
+  display.showInt(7);
+  expectFrame("7 (padded left)", B, B, B, symbols.seven);
+
+  display.showInt(-12);
+  expectFrame("-12", B, symbols.hyphen, symbols.one, symbols.two);
+
+  display.showInt(-999);
+  expectFrame("-999 (negative, full width)", symbols.hyphen, symbols.nine, symbols.nine, symbols.nine);
+}
+
+void testShowFloat()
+{
+  printf("showFloat\n");
+  setUp();
+
+  display.showFloat(2.1987, 2);
+  expectFrame("2.1987, 2 places", B, symbols.addDot(symbols.two), symbols.one, symbols.nine);
+
+  display.showFloat(-1.5, 1);
+  expectFrame("-1.5, 1 place", B, symbols.hyphen, symbols.addDot(symbols.one), symbols.five);
+
+  display.showFloat(12.34, 2);
+  expectFrame("12.34, 2 places", symbols.one, symbols.addDot(symbols.two), symbols.three, symbols.four);
+
+  // more decimal places than digits: 2.5 with 5 places = "2.50000", scrolls.
+  setUp();
+  display.showFloat(2.5, 5);
+
+  const byte decimals[] = {
+    B, B, B, symbols.addDot(symbols.two),
+    B, B, symbols.addDot(symbols.two), symbols.five,
+    B, symbols.addDot(symbols.two), symbols.five, symbols.zero,
+    symbols.addDot(symbols.two), symbols.five, symbols.zero, symbols.zero,
+    symbols.five, symbols.zero, symbols.zero, symbols.zero,
+    symbols.zero, symbols.zero, symbols.zero, symbols.zero
+  };
+
+  expectScrolling("2.5, 5 places", decimals, 6);
+}
+
+void testShowHex()
+{
+  printf("showHex\n");
+  setUp();
+
+  display.showHex(429);
+  expectFrame("0x1ad", B, symbols.one, symbols.letter_A, symbols.letter_d);
+
+  display.showHex(0xbcef);
+  expectFrame("0xbcef", symbols.letter_b, symbols.letter_C, symbols.letter_E, symbols.letter_F);
+
+  display.showHex(0);
+  expectFrame("0x0", B, B, B, symbols.zero);
+}
+
+void testShowError()
+{
+  printf("showError\n");
+  setUp();
+
+  display.showInt(42);
+  display.showError();
+  runUntil(1100);
+  expectFrame("error shown", symbols.letter_E, symbols.letter_r, symbols.letter_r, B);
+
+  // error disappears after 3 seconds, the value is shown again.
+  runUntil(4100);
+  expectFrame("value after error", B, B, symbols.four, symbols.two);
+}
+
+void testScrolling()
+{
+  printf("scrolling\n");
+  setUp();
+
+  display.showInt(12345);
+
+  const byte scrolling[] = {
+    B, B, B, symbols.one,
+    B, B, symbols.one, symbols.two,
+    B, symbols.one, symbols.two, symbols.three,
+    symbols.one, symbols.two, symbols.three, symbols.four,
+    symbols.two, symbols.three, symbols.four, symbols.five,
+    symbols.three, symbols.four, symbols.five, B,
+    symbols.four, symbols.five, B, B,
+    symbols.five, B, B, B,
+    B, B, B, B,
+    B, B, B, symbols.one // animation starts again.
+  };
+
+  expectScrolling("12345", scrolling, 10);
+
+  // negative number longer than the display.
+  setUp();
+  display.showInt(-12345);
+
+  const byte negative[] = {
+    B, B, B, symbols.hyphen,
+    B, B, symbols.hyphen, symbols.one,
+    B, symbols.hyphen, symbols.one, symbols.two,
+    symbols.hyphen, symbols.one, symbols.two, symbols.three,
+    symbols.one, symbols.two, symbols.three, symbols.four,
+    symbols.two, symbols.three, symbols.four, symbols.five
+  };
+
+  expectScrolling("-12345", negative, 6);
+
+  // setting carousel pages doesn't change a scrolling show*() value.
+  setUp();
+  display.showInt(12345);
+  display.setPageInt(1, 7);
+  display.setPageFloat(2, 2.5, 5);
+  display.setPageHex(3, 0xbcef);
+
+  expectScrolling("12345 after setPage*()", scrolling, 10);
+
+  // maximum input length (9 chars), longer input is cut off.
+  setUp();
+  display.showText("123456789ab");
+
+  const byte maxLength[] = {
+    symbols.six, symbols.seven, symbols.eight, symbols.nine,
+    symbols.seven, symbols.eight, symbols.nine, B,
+    symbols.eight, symbols.nine, B, B,
+    symbols.nine, B, B, B,
+    B, B, B, B
+  };
+
+  runUntil(1000 + 300 * 8);
+  expectScrolling("max length", maxLength, 5);
+}
+
+void testStream()
+{
+  printf("stream\n");
+  setUp();
+
+  // committed values are rounded to the last shown digit.
+  display.setStreamMode('l', 10);
+  display.push(2.6);
+  runUntil(1200);
+  expectFrame("2.6, 0 places", B, B, B, symbols.three);
+
+  display.setStreamMode('l', 10, 1);
+  display.push(2.96);
+  runUntil(1400);
+  expectFrame("2.96, 1 place", B, B, symbols.addDot(symbols.three), symbols.zero);
+
+  display.push(-1.44);
+  runUntil(1600);
+  expectFrame("-1.44, 1 place", B, symbols.hyphen, symbols.addDot(symbols.one), symbols.four);
+}
+
+void testCarousel()
+{
+  printf("carousel\n");
+  setUp();
+
+  display.setPageInt(0, 123456);
+  display.setPageInt(1, 42);
+  display.startCarousel(2, 10000);
+
+  unsigned long start = virtualMCU.getMicros() / 1000;
+
+  const byte scrolling[] = {
+    symbols.five, symbols.six, B, B,
+    symbols.six, B, B, B,
+    B, B, B, B,
+    B, B, B, symbols.one // animation starts again.
+  };
+
+  // re-rendering a page must not change the page that is scrolling.
+  runUntil(start + 300 * 7 + 100);
+  expectFrame("123456 frame 7", scrolling[0], scrolling[1], scrolling[2], scrolling[3]);
+  display.setPageInt(1, 12345);
+
+  runUntil(start + 300 * 8 + 100);
+  expectFrame("123456 frame 8", scrolling[4], scrolling[5], scrolling[6], scrolling[7]);
+  runUntil(start + 300 * 9 + 100);
+  expectFrame("123456 frame 9", scrolling[8], scrolling[9], scrolling[10], scrolling[11]);
+  runUntil(start + 300 * 10 + 100);
+  expectFrame("123456 frame 0", scrolling[12], scrolling[13], scrolling[14], scrolling[15]);
+
+  // the re-rendered page scrolls from its own frames.
+  runUntil(start + 10000 + 300 * 4 + 100);
+  expectFrame("12345 frame 4", symbols.two, symbols.three, symbols.four, symbols.five);
+}
+
+int main()
+{
+  for (int mode = 0; mode < 2; mode++)
+  {
+    blankSkipping = (mode == 1);
+    printf("--- blank skipping %s ---\n", blankSkipping ? "on" : "off");
+
+    testShowInt();
+    testShowFloat();
+    testShowHex();
+    testShowError();
+    testScrolling();
+    testStream();
+    testCarousel();
+  }
+
+  if (failures > 0)
+  {
+    printf("%d golden test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("golden tests passed\n");
+  return 0;
+}
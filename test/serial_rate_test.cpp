@@ -0,0 +1,226 @@
+/*
+  serial_rate_test.cpp - Throughput and validation of the serial protocol.
+
+  Feeds serial protocol frames through a VirtualStream and measures how
+  many updates per second Seg4DigitHC164::loop() sustains, in virtual
+  time (digitalWrite() and read() costs of the VirtualMCU). Time spent on
+  calculations (like snprintf() in showInt()) is not part of the virtual
+  time, so the rates of the value and text frames are upper limits. The
+  library is built with SEG4DIGIT_DEBUG 0, so no debug text is printed
+  on the serial path (HostSerial would discard it without any cost).
+  Also checks that accepted frames appear on the display (reconstructed
+  from the pin trace), and that invalid frames are rejected and counted.
+
+  Build and run with test/build.sh.
+*/
+
+#include <stdio.h>
+#include "../include/Seg4DigitHC164.h"
+#include "../include/BinarySymbols.h"
+
+#define NUM_OF_FRAMES 1000
+
+byte dataPin = 2;
+byte clockPin = 3;
+byte digitPins[] = {8, 9, 10, 11};
+
+Seg4DigitHC164 display;
+VirtualStream stream;
+BinarySymbols symbols;
+int failures = 0;
+
+void setUp()
+{
+  virtualMCU.reset();
+  virtualMCU.attachDisplay(dataPin, clockPin, digitPins, NUM_OF_DISPLAY_DIGITS);
+  display.init(dataPin, clockPin, digitPins);
+  display.attachSerial(&stream);
+}
+
+void writeFrame(byte type, const byte* payload, byte length)
+// write a complete frame (sync, type, length, payload, checksum) to the stream.
+{
+  byte checksum = type ^ length;
+
+  for (int i = 0; i < length; i++)
+  {
+    checksum ^= payload[i];
+  }
+
+  stream.write(SERIAL_SYNC);
+  stream.write(type);
+  stream.write(length);
+  stream.write(payload, length);
+  stream.write(checksum);
+}
+
+void writeValueFrame(char format, byte decimalPlaces, const void* value)
+{
+  byte payload[6] = {(byte)format, decimalPlaces};
+  memcpy(&payload[2], value, 4); // little endian host.
+  writeFrame(SERIAL_TYPE_VALUE, payload, 6);
+}
+
+void displayLoop()
+{
+  display.loop();
+}
+
+unsigned long consumeStream()
+// call loop() until all bytes are read, returns the virtual time spent (microseconds).
+{
+  unsigned long start = virtualMCU.getMicros();
+
+  while (stream.available() > 0)
+  {
+    display.loop();
+    virtualMCU.advance(10); // loop overhead.
+  }
+
+  return virtualMCU.getMicros() - start;
+}
+
+void expectCount(const char* name, unsigned long seen, unsigned long expected)
+{
+  if (seen == expected)
+  {
+    printf("  ok    %s\n", name);
+  }
+  else
+  {
+    printf("  FAIL  %s: expected %lu, seen %lu\n", name, expected, seen);
+    failures++;
+  }
+}
+
+void expectShown(const char* name, const byte* expected)
+// trace two multiplex cycles and compare the perceived frame of the first full cycle.
+{
+  PerceivedFrame frame;
+
+  virtualMCU.startTrace();
+  virtualMCU.runFor(40000, displayLoop);
+  virtualMCU.stopTrace();
+
+  if (virtualMCU.reconstructFrame(virtualMCU.getCycleStart(0), virtualMCU.getCycleStart(1), frame) &&
+    virtualMCU.frameMatches(frame, expected))
+  {
+    printf("  ok    %s\n", name);
+  }
+  else
+  {
+    printf("  FAIL  %s: frame not shown\n", name);
+    failures++;
+  }
+}
+
+void measure(const char* name, byte type, const byte* payload, byte length)
+// write NUM_OF_FRAMES frames, consume them and report the update rate.
+{
+  setUp();
+
+  for (int i = 0; i < NUM_OF_FRAMES; i++)
+  {
+    writeFrame(type, payload, length);
+  }
+
+  unsigned long duration = consumeStream();
+
+  printf("  %-10s %d frames in %lu us: %.0f updates/s\n", name, NUM_OF_FRAMES, duration,
+    display.getSerialFramesAccepted() * 1000000.0 / duration);
+  expectCount("all frames accepted", display.getSerialFramesAccepted(), NUM_OF_FRAMES);
+}
+
+void testRates()
+{
+  printf("update rates\n");
+
+  byte segments[NUM_OF_DISPLAY_DIGITS] = {BinarySymbols::one, BinarySymbols::two, BinarySymbols::three, BinarySymbols::four};
+  measure("segments", SERIAL_TYPE_SEGMENTS, segments, NUM_OF_DISPLAY_DIGITS);
+
+  int32_t intValue = 1234;
+  byte intPayload[6] = {'i', 0};
+  memcpy(&intPayload[2], &intValue, 4);
+  measure("int", SERIAL_TYPE_VALUE, intPayload, 6);
+
+  const char* text = "12345";
+  measure("text", SERIAL_TYPE_TEXT, (const byte*)text, 5);
+}
+
+void testShown()
+{
+  printf("shown frames\n");
+  setUp();
+
+  byte segments[NUM_OF_DISPLAY_DIGITS] = {BinarySymbols::four, BinarySymbols::three, BinarySymbols::two, BinarySymbols::one};
+  writeFrame(SERIAL_TYPE_SEGMENTS, segments, NUM_OF_DISPLAY_DIGITS);
+  consumeStream();
+  expectShown("segments 4321", segments);
+
+  int32_t intValue = -42;
+  writeValueFrame('i', 0, &intValue);
+  consumeStream();
+  const byte intSymbols[] = {BinarySymbols::blank, BinarySymbols::hyphen, BinarySymbols::four, BinarySymbols::two};
+  expectShown("int -42", intSymbols);
+
+  float floatValue = 1.25;
+  writeValueFrame('f', 2, &floatValue);
+  consumeStream();
+  const byte floatSymbols[] = {BinarySymbols::blank, symbols.addDot(BinarySymbols::one), BinarySymbols::two, BinarySymbols::five};
+  expectShown("float 1.25", floatSymbols);
+
+  const char* text = "Err";
+  writeFrame(SERIAL_TYPE_TEXT, (const byte*)text, 3);
+  consumeStream();
+  const byte textSymbols[] = {BinarySymbols::blank, BinarySymbols::letter_E, BinarySymbols::letter_r, BinarySymbols::letter_r};
+  expectShown("text Err", textSymbols);
+}
+
+void testRejected()
+{
+  printf("rejected frames\n");
+  setUp();
+
+  // wrong checksum.
+  byte badChecksum[] = {SERIAL_SYNC, SERIAL_TYPE_BRIGHTNESS, 1, 100, 0};
+  stream.write(badChecksum, sizeof(badChecksum));
+
+  // wrong payload length for raw segments.
+  byte segments[2] = {BinarySymbols::one, BinarySymbols::two};
+  writeFrame(SERIAL_TYPE_SEGMENTS, segments, 2);
+
+  // more decimal places than the maximum input length.
+  float floatValue = 1.5;
+  writeValueFrame('f', 40, &floatValue);
+
+  // too large for the decimal places, and infinity.
+  floatValue = 1e30;
+  writeValueFrame('f', 2, &floatValue);
+  floatValue = INFINITY;
+  writeValueFrame('f', 0, &floatValue);
+
+  // a valid frame, to check the parser recovers.
+  floatValue = 2.5;
+  writeValueFrame('f', 1, &floatValue);
+
+  consumeStream();
+
+  expectCount("rejected frames", display.getSerialFramesRejected(), 5);
+  expectCount("accepted frames", display.getSerialFramesAccepted(), 1);
+}
+
+int main()
+{
+  testRates();
+  testShown();
+  testRejected();
+
+  if (failures > 0)
+  {
+    printf("%d serial test(s) failed\n", failures);
+    return 1;
+  }
+
+  printf("serial tests passed\n");
+  return 0;
+}